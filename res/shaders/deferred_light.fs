@@ -0,0 +1,63 @@
+#version 330 core
+
+// Shades the pixels under one light volume from the G-buffer (GBUFFER_PASS permutation of multiple_lights.fs),
+// the result is added to the accumulation buffer. Must match CalcPointLight in multiple_lights.fs.
+
+out vec4 FragColor;
+
+flat in vec4 PositionRadius; // position + influence radius
+flat in vec4 AmbientConstant;
+flat in vec4 DiffuseLinear;
+flat in vec4 SpecularQuadratic;
+
+// camera of the frame, shared by all programs (binding point 0)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos; // w unused
+};
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gSpecular;
+uniform sampler2D gNormal; // world space, mapped to 0..1
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform vec2 inverseScreenSize;
+uniform float shininess;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy * inverseScreenSize;
+    float depth = texture(gDepth, uv).r;
+    // background, nothing to shade
+    if (depth == 1.0)
+        discard;
+
+    // world position of the pixel, reconstructed from its depth
+    vec4 position = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = position.xyz / position.w;
+    float distance = length(PositionRadius.xyz - fragPos);
+    // the volume is only a bound, most of its pixels are out of the light's reach
+    if (distance > PositionRadius.w)
+        discard;
+
+    vec3 normal = normalize(texture(gNormal, uv).xyz * 2.0 - 1.0);
+    vec3 diffuseColor = texture(gAlbedo, uv).rgb;
+    vec3 specularColor = texture(gSpecular, uv).rgb;
+    vec3 viewDir = normalize(viewPos.xyz - fragPos);
+    vec3 lightDir = normalize(PositionRadius.xyz - fragPos);
+
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // attenuation
+    float attenuation = 1.0 / (AmbientConstant.w + DiffuseLinear.w * distance + SpecularQuadratic.w * (distance * distance));
+    // combine results
+    vec3 ambient = AmbientConstant.rgb * diffuseColor;
+    vec3 diffuse = DiffuseLinear.rgb * diff * diffuseColor;
+    vec3 specular = SpecularQuadratic.rgb * spec * specularColor;
+    FragColor = vec4((ambient + diffuse + specular) * attenuation, 1.0);
+}
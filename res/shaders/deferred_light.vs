@@ -0,0 +1,34 @@
+#version 330 core
+
+// light volume - unit sphere, one instance per point light
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in vec4 aPositionRadius;
+layout (location = 4) in vec4 aAmbientConstant;
+layout (location = 5) in vec4 aDiffuseLinear;
+layout (location = 6) in vec4 aSpecularQuadratic;
+
+flat out vec4 PositionRadius;
+flat out vec4 AmbientConstant;
+flat out vec4 DiffuseLinear;
+flat out vec4 SpecularQuadratic;
+
+uniform float volumeScale; // the tessellated sphere lies inside the unit sphere, scaled up to enclose the radius
+
+// camera of the frame, shared by all programs (binding point 0)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos; // w unused
+};
+
+void main()
+{
+    PositionRadius = aPositionRadius;
+    AmbientConstant = aAmbientConstant;
+    DiffuseLinear = aDiffuseLinear;
+    SpecularQuadratic = aSpecularQuadratic;
+
+    vec3 worldPos = aPositionRadius.xyz + aPos * (aPositionRadius.w * volumeScale);
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
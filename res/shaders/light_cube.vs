@@ -2,8 +2,14 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// camera of the frame, shared by all programs (binding point 0)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos; // w unused
+};
 
 void main()
 {
@@ -1,10 +1,37 @@
 #version 330 core
 
+// Permutation defines, injected by LightingShaderCache (defaults keep the file usable on its own):
+// NR_POINT_LIGHTS  - number of point lights in LightData block (0 or more)
+// HAS_DIR_LIGHT    - evaluate the directional light
+// HAS_SPECULAR_MAP - sample material.specular and add specular terms (without it there is no specular at all)
+// CLUSTERED_LIGHTING - evaluate the lights of the fragment's froxel (ClusteredLighting), on top of NR_POINT_LIGHTS
+// LIGHT_CULLING    - evaluate only the point lights of the object's list (objectLights), not all NR_POINT_LIGHTS
+// SHADOWS          - shadow point lights by the cube faces in the shadow atlas (ShadowMaps), the first MAX_SHADOWED_LIGHTS only
+// TEXTURE_ARRAYS   - material maps are layers of TextureArrays, sampled within the object's rectangle of its layer
+// GBUFFER_PASS     - write material and normal into the G-buffer instead of lighting (DeferredShading lights it later)
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 2
+#endif
+
+#ifdef GBUFFER_PASS
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gSpecular;
+layout (location = 2) out vec4 gNormal; // world space, mapped to 0..1
+#else
 out vec4 FragColor;
+#endif
+
+#ifdef TEXTURE_ARRAYS
+#define MATERIAL_SAMPLER sampler2DArray
+#else
+#define MATERIAL_SAMPLER sampler2D
+#endif
 
 struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
+    MATERIAL_SAMPLER diffuse;
+#ifdef HAS_SPECULAR_MAP
+    MATERIAL_SAMPLER specular;
+#endif
     float shininess;
 }; 
 
@@ -15,87 +42,264 @@ struct DirLight {
     vec3 specular;
 };
 
+// std140 - every scalar fills the padding after a vec3, mirrored by PointLightBlock in UniformBlocks.h
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
-#define NR_POINT_LIGHTS 2
-
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+#ifdef TEXTURE_ARRAYS
+flat in vec4 DiffuseRect; // scale xy, offset zw
+flat in vec4 SpecularRect;
+flat in vec2 TextureLayers; // diffuse, specular
+#endif
+
+// camera of the frame, shared by all programs (binding point 0)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos; // w unused
+};
+
+#if NR_POINT_LIGHTS > 0
+// point lights, shared by all programs (binding point 1)
+layout (std140) uniform LightData
+{
+    PointLight pointLights[NR_POINT_LIGHTS];
+};
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+// froxel grid - screen tiles times exponential depth slices (binding point 2), mirrored by ClusterBlock in UniformBlocks.h
+layout (std140) uniform ClusterData
+{
+    uvec4 clusterGridSize; // tiles x, y, depth slices, number of lights
+    vec4 clusterGridScale; // tiles per pixel x, y, depth slice = log(depth) * z + w
+};
+uniform samplerBuffer clusterLights; // 4 texels per light: position + radius, ambient + constant, diffuse + linear, specular + quadratic
+uniform usamplerBuffer clusterGrid; // offset and count of light indices per cluster
+uniform usamplerBuffer clusterLightIndices; // light indices of all clusters one after another
+#endif
+
+#ifdef LIGHT_CULLING
+// indices into pointLights of the lights touching the object, found by LightCulling on the CPU
+// (size must match MAX_LIGHTS_PER_OBJECT in UniformBlocks.h)
+uniform int objectLightCount;
+uniform int objectLights[16];
+#endif
+
+#ifdef SHADOWS
+// shadows of the first point lights, shared by all programs (binding point 3), mirrored by ShadowBlock in UniformBlocks.h
+layout (std140) uniform ShadowData
+{
+    vec4 shadowLights[4]; // near plane, far plane, 1 if the light casts shadows, unused (size must match MAX_SHADOWED_LIGHTS)
+    vec4 shadowAtlasLayout; // size of one cube face in texels, rows of faces, unused
+};
+uniform sampler2DShadow shadowAtlas; // six cube faces per light in a row, in order +x, -x, +y, -y, +z, -z
 
-uniform vec3 viewPos;
+// must match FACE_FORWARD and FACE_UP in ShadowMaps.cpp
+const vec3 SHADOW_FACE_FORWARD[6] = vec3[6](vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0),
+    vec3(0.0, -1.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+const vec3 SHADOW_FACE_UP[6] = vec3[6](vec3(0.0, -1.0, 0.0), vec3(0.0, -1.0, 0.0), vec3(0.0, 0.0, 1.0),
+    vec3(0.0, 0.0, -1.0), vec3(0.0, -1.0, 0.0), vec3(0.0, -1.0, 0.0));
+#endif
+
+#ifdef HAS_DIR_LIGHT
 uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+#endif
 uniform Material material;
 
 // function prototypes
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow);
+float CalcShadow(int light, vec3 lightPosition, vec3 normal, vec3 fragPos);
+#ifdef TEXTURE_ARRAYS
+vec4 SampleMaterial(sampler2DArray map, vec4 rect, float layer);
+#endif
+vec3 CalcClusteredLights(vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor);
 
 void main()
 {    
     // properties
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
-    
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
+
+    // material textures are sampled once per fragment, not once per light
+#ifdef TEXTURE_ARRAYS
+    vec3 diffuseColor = vec3(SampleMaterial(material.diffuse, DiffuseRect, TextureLayers.x));
+#else
+    vec3 diffuseColor = vec3(texture(material.diffuse, TexCoords));
+#endif
+#if defined(HAS_SPECULAR_MAP) && defined(TEXTURE_ARRAYS)
+    vec3 specularColor = vec3(SampleMaterial(material.specular, SpecularRect, TextureLayers.y));
+#elif defined(HAS_SPECULAR_MAP)
+    vec3 specularColor = vec3(texture(material.specular, TexCoords));
+#else
+    vec3 specularColor = vec3(0.0);
+#endif
+
+#ifdef GBUFFER_PASS
+    // lights are evaluated per pixel by DeferredShading, only what they need is stored
+    gAlbedo = vec4(diffuseColor, 1.0);
+    gSpecular = vec4(specularColor, 1.0);
+    gNormal = vec4(norm * 0.5 + 0.5, 1.0);
+#else
     // == =====================================================
-    // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
+    // Our lighting is set up in 2 phases: directional and point lights
     // For each phase, a calculate function is defined that calculates the corresponding color
     // per lamp. In the main() function we take all the calculated colors and sum them up for
-    // this fragment's final color.
+    // this fragment's final color. Phases the permutation has no lights for are compiled out.
     // == =====================================================
+    vec3 result = vec3(0.0);
     // phase 1: directional lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+#ifdef HAS_DIR_LIGHT
+    result += CalcDirLight(dirLight, norm, viewDir, diffuseColor, specularColor);
+#endif
     // phase 2: point lights
+#if NR_POINT_LIGHTS > 0 && defined(LIGHT_CULLING)
+    for(int i = 0; i < objectLightCount; i++)
+        result += CalcPointLight(pointLights[objectLights[i]], norm, FragPos, viewDir, diffuseColor, specularColor,
+            CalcShadow(objectLights[i], pointLights[objectLights[i]].position, norm, FragPos));
+#elif NR_POINT_LIGHTS > 0
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, diffuseColor, specularColor,
+            CalcShadow(i, pointLights[i].position, norm, FragPos));
+#endif
+    // phase 3: lights of the froxel
+#ifdef CLUSTERED_LIGHTING
+    result += CalcClusteredLights(norm, FragPos, viewDir, diffuseColor, specularColor);
+#endif
     
     FragColor = vec4(result, 1.0);
+#endif
+}
+
+// calculates the specular factor (nothing to calculate without specular map)
+float CalcSpecular(vec3 lightDir, vec3 normal, vec3 viewDir)
+{
+#ifdef HAS_SPECULAR_MAP
+    vec3 reflectDir = reflect(-lightDir, normal);
+    return pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+#else
+    return 0.0;
+#endif
 }
 
 // calculates the color when using a directional light.
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor)
 {
     vec3 lightDir = normalize(-light.direction);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = CalcSpecular(lightDir, normal, viewDir);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * diffuseColor;
+    vec3 diffuse = light.diffuse * diff * diffuseColor;
+    vec3 specular = light.specular * spec * specularColor;
     return (ambient + diffuse + specular);
 }
 
-// calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+// calculates the color when using a point light, diffuse and specular terms are scaled by the shadow factor.
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow)
 {
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = CalcSpecular(lightDir, normal, viewDir);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * diffuseColor;
+    vec3 diffuse = light.diffuse * diff * diffuseColor;
+    vec3 specular = light.specular * spec * specularColor;
     ambient *= attenuation;
-    diffuse *= attenuation;
-    specular *= attenuation;
+    diffuse *= attenuation * shadow;
+    specular *= attenuation * shadow;
     return (ambient + diffuse + specular);
-}
\ No newline at end of file
+}
+
+// calculates how much of the point light reaches the fragment (1 = lit, 0 = in shadow)
+float CalcShadow(int light, vec3 lightPosition, vec3 normal, vec3 fragPos)
+{
+#ifdef SHADOWS
+    if (light >= 4 || shadowLights[light].z == 0.0)
+        return 1.0;
+    vec3 toFragment = fragPos - lightPosition;
+    // pushed out along the normal by about a texel and a half of the face, against shadow acne
+    float distanceToLight = max(abs(toFragment.x), max(abs(toFragment.y), abs(toFragment.z)));
+    toFragment += normal * (3.0 * distanceToLight / shadowAtlasLayout.x);
+
+    // cube face of the major axis, then the same projection the face has been rendered with (90 degrees field of view)
+    vec3 axes = abs(toFragment);
+    int face = axes.x >= axes.y && axes.x >= axes.z ? (toFragment.x > 0.0 ? 0 : 1)
+        : (axes.y >= axes.z ? (toFragment.y > 0.0 ? 2 : 3) : (toFragment.z > 0.0 ? 4 : 5));
+    float major = dot(toFragment, SHADOW_FACE_FORWARD[face]);
+    float nearPlane = shadowLights[light].x;
+    float farPlane = shadowLights[light].y;
+    if (major >= farPlane)
+        return 1.0;
+    float depth = ((farPlane + nearPlane) / (farPlane - nearPlane) - 2.0 * farPlane * nearPlane / ((farPlane - nearPlane) * major)) * 0.5 + 0.5;
+    vec3 up = SHADOW_FACE_UP[face];
+    vec2 uv = vec2(dot(toFragment, cross(SHADOW_FACE_FORWARD[face], up)), dot(toFragment, up)) / major * 0.5 + 0.5;
+
+    // half a texel off the face border, so that filtering never reads the neighbouring face
+    float border = 0.5 / shadowAtlasLayout.x;
+    uv = clamp(uv, vec2(border), vec2(1.0 - border));
+    return texture(shadowAtlas, vec3((vec2(face, light) + uv) / vec2(6.0, shadowAtlasLayout.y), depth));
+#else
+    return 1.0;
+#endif
+}
+
+#ifdef CLUSTERED_LIGHTING
+// calculates the color of all lights whose influence reaches the fragment's froxel
+vec3 CalcClusteredLights(vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor)
+{
+    // froxel of the fragment
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    uvec2 tile = uvec2(gl_FragCoord.xy * clusterGridScale.xy);
+    uint slice = uint(max(log(depth) * clusterGridScale.z + clusterGridScale.w, 0.0));
+    uvec3 froxel = min(uvec3(tile, slice), clusterGridSize.xyz - uvec3(1u));
+    int cluster = int(froxel.x + clusterGridSize.x * (froxel.y + clusterGridSize.y * froxel.z));
+    uvec2 lights = texelFetch(clusterGrid, cluster).xy;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < lights.y; i++)
+    {
+        int texel = int(texelFetch(clusterLightIndices, int(lights.x + i)).x) * 4;
+        vec4 positionRadius = texelFetch(clusterLights, texel);
+        // froxels are coarse, most of their lights do not reach the fragment itself
+        if (distance(positionRadius.xyz, fragPos) > positionRadius.w)
+            continue;
+        vec4 ambientConstant = texelFetch(clusterLights, texel + 1);
+        vec4 diffuseLinear = texelFetch(clusterLights, texel + 2);
+        vec4 specularQuadratic = texelFetch(clusterLights, texel + 3);
+        PointLight light = PointLight(positionRadius.xyz, ambientConstant.w, ambientConstant.rgb, diffuseLinear.w,
+            diffuseLinear.rgb, specularQuadratic.w, specularQuadratic.rgb);
+        result += CalcPointLight(light, normal, fragPos, viewDir, diffuseColor, specularColor, 1.0);
+    }
+    return result;
+}
+#endif
+
+#ifdef TEXTURE_ARRAYS
+// wraps the texture coordinates into the map's rectangle of its layer, gradients of the unwrapped coordinates
+// keep the mip level continuous across the wrap (the atlas gutter covers the filter footprint)
+vec4 SampleMaterial(sampler2DArray map, vec4 rect, float layer)
+{
+    vec2 uv = fract(TexCoords) * rect.xy + rect.zw;
+    return textureGrad(map, vec3(uv, layer), dFdx(TexCoords) * rect.xy, dFdy(TexCoords) * rect.xy);
+}
+#endif
\ No newline at end of file
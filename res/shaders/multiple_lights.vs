@@ -9,14 +9,40 @@ out vec3 Normal;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix; // inverse transpose of model, computed once per object on the CPU
+
+#ifdef TEXTURE_ARRAYS
+// rectangles (scale xy, offset zw) and layers of the material maps in TextureArrays, diffuse first
+uniform vec4 textureRects[2];
+uniform float textureLayers[2];
+
+flat out vec4 DiffuseRect;
+flat out vec4 SpecularRect;
+flat out vec2 TextureLayers;
+#endif
+
+// camera of the frame, shared by all programs (binding point 0)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos; // w unused
+};
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+#ifdef LEGACY_NORMAL_MATRIX
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+#else
+    Normal = normalMatrix * aNormal;
+#endif
     TexCoords = aTexCoords;
+#ifdef TEXTURE_ARRAYS
+    DiffuseRect = textureRects[0];
+    SpecularRect = textureRects[1];
+    TextureLayers = vec2(textureLayers[0], textureLayers[1]);
+#endif
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+// per-instance attributes
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec2 aRadiusHeight;
+layout (location = 8) in mat3 aNormalMatrix; // inverse transpose of model with radius / height, computed on the CPU
+#ifdef TEXTURE_ARRAYS
+layout (location = 11) in vec4 aDiffuseRect; // rectangle (scale xy, offset zw) of the diffuse map in TextureArrays
+layout (location = 12) in vec4 aSpecularRect;
+layout (location = 13) in vec2 aTextureLayers; // layers of the diffuse and specular maps
+#endif
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+#ifdef TEXTURE_ARRAYS
+flat out vec4 DiffuseRect;
+flat out vec4 SpecularRect;
+flat out vec2 TextureLayers;
+#endif
+
+// camera of the frame, shared by all programs (binding point 0)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos; // w unused
+};
+
+void main()
+{
+    // stretch the unit cylinder to the instance radius (x, z) and height (y)
+    vec3 scale = vec3(aRadiusHeight.x, aRadiusHeight.y, aRadiusHeight.x);
+    FragPos = vec3(aModel * vec4(aPos * scale, 1.0));
+#ifdef LEGACY_NORMAL_MATRIX
+    Normal = mat3(transpose(inverse(aModel))) * (aNormal / scale);
+#else
+    Normal = aNormalMatrix * aNormal;
+#endif
+    TexCoords = aTexCoords;
+#ifdef TEXTURE_ARRAYS
+    DiffuseRect = aDiffuseRect;
+    SpecularRect = aSpecularRect;
+    TextureLayers = aTextureLayers;
+#endif
+    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth only, the shadow atlas has no color
+void main()
+{
+}
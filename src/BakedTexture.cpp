@@ -0,0 +1,442 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Project
+#include "BakedTexture.h"
+#include "GLDebug.h"
+#include "MappedFile.h"
+#include "TextureStorage.h"
+#include "stb_image.h"
+
+namespace {
+
+	const char TEXTURE_FILE_MAGIC[4] = { 'T', 'E', 'X', 'B' };
+	const uint32_t TEXTURE_FILE_VERSION = 1;
+
+	// Mip chain of the largest texture there can be (32768 texels wide)
+	const uint32_t MAX_LEVELS = 16;
+
+	/** Header of the baked texture, followed by numLevels level records and their block data at given offsets. */
+	struct TextureFileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t format; //! BakedTextureFormat
+		uint32_t width;
+		uint32_t height;
+		uint32_t numLevels;
+	};
+
+	/** One mip level of the baked texture, its blocks go row by row. */
+	struct TextureFileLevel
+	{
+		uint32_t offset;
+		uint32_t size;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	/** RGBA8 image of one mip level. */
+	struct Level
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+	};
+
+	size_t getBlockSize(uint32_t format)
+	{
+		return format == BAKED_TEXTURE_BC1 ? 8 : 16;
+	}
+
+	// Next mip level, every texel averages the 2x2 texels under it (repeated at the edge of odd sizes)
+	Level downsample(const Level& level)
+	{
+		Level result = { std::max(level.width / 2, 1), std::max(level.height / 2, 1), {} };
+		result.pixels.resize(size_t(result.width) * result.height * 4);
+		for (auto y = 0; y < result.height; y++)
+		{
+			const int rows[2] = { std::min(y * 2, level.height - 1), std::min(y * 2 + 1, level.height - 1) };
+			for (auto x = 0; x < result.width; x++)
+			{
+				const int columns[2] = { std::min(x * 2, level.width - 1), std::min(x * 2 + 1, level.width - 1) };
+				for (auto channel = 0; channel < 4; channel++)
+				{
+					auto sum = 2; // rounds to nearest
+					for (auto row : rows)
+					{
+						for (auto column : columns) {
+							sum += level.pixels[(size_t(row) * level.width + column) * 4 + channel];
+						}
+					}
+					result.pixels[(size_t(y) * result.width + x) * 4 + channel] = (unsigned char)(sum / 4);
+				}
+			}
+		}
+		return result;
+	}
+
+	uint16_t packColor565(const float color[3])
+	{
+		const auto quantize = [](float value, int maximum) {
+			return std::min(std::max(int(std::lround(value * maximum / 255.0f)), 0), maximum);
+		};
+		return uint16_t((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+	}
+
+	void unpackColor565(uint16_t packed, int color[3])
+	{
+		const auto r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Color part of BC1 and BC3 blocks - endpoints are the extremes of the texels along their principal axis,
+	// every texel then takes the closest of the four colors interpolated between them
+	void encodeColorBlock(const unsigned char texels[16 * 4], unsigned char* block)
+	{
+		float mean[3] = {};
+		for (auto i = 0; i < 16; i++)
+		{
+			for (auto c = 0; c < 3; c++) {
+				mean[c] += texels[i * 4 + c] / 16.0f;
+			}
+		}
+		float covariance[6] = {}; // rr, rg, rb, gg, gb, bb
+		for (auto i = 0; i < 16; i++)
+		{
+			const float d[3] = { texels[i * 4] - mean[0], texels[i * 4 + 1] - mean[1], texels[i * 4 + 2] - mean[2] };
+			covariance[0] += d[0] * d[0];
+			covariance[1] += d[0] * d[1];
+			covariance[2] += d[0] * d[2];
+			covariance[3] += d[1] * d[1];
+			covariance[4] += d[1] * d[2];
+			covariance[5] += d[2] * d[2];
+		}
+
+		// a few power iterations are plenty for a 3x3 matrix
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (auto iteration = 0; iteration < 8; iteration++)
+		{
+			const float next[3] = {
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+			};
+			const auto length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+			if (length < 1e-6f) {
+				break;
+			}
+			for (auto c = 0; c < 3; c++) {
+				axis[c] = next[c] / length;
+			}
+		}
+
+		auto minProjection = 0.0f, maxProjection = 0.0f;
+		for (auto i = 0; i < 16; i++)
+		{
+			auto projection = 0.0f;
+			for (auto c = 0; c < 3; c++) {
+				projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+			}
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+		float endpoints[2][3];
+		for (auto c = 0; c < 3; c++)
+		{
+			endpoints[0][c] = mean[c] + axis[c] * maxProjection;
+			endpoints[1][c] = mean[c] + axis[c] * minProjection;
+		}
+
+		// the larger endpoint goes first, which selects the four color mode
+		auto color0 = packColor565(endpoints[0]), color1 = packColor565(endpoints[1]);
+		if (color0 < color1) {
+			std::swap(color0, color1);
+		}
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			unpackColor565(color0, palette[0]);
+			unpackColor565(color1, palette[1]);
+			for (auto c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (auto i = 0; i < 16; i++)
+			{
+				auto bestIndex = 0, bestDistance = INT32_MAX;
+				for (auto index = 0; index < 4; index++)
+				{
+					auto distance = 0;
+					for (auto c = 0; c < 3; c++)
+					{
+						const auto d = texels[i * 4 + c] - palette[index][c];
+						distance += d * d;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+				indices |= uint32_t(bestIndex) << (i * 2);
+			}
+		}
+
+		block[0] = (unsigned char)(color0 & 0xFF);
+		block[1] = (unsigned char)(color0 >> 8);
+		block[2] = (unsigned char)(color1 & 0xFF);
+		block[3] = (unsigned char)(color1 >> 8);
+		for (auto i = 0; i < 4; i++) {
+			block[4 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+	// Alpha part of BC3 blocks - endpoints are the alpha extremes, with six values interpolated between them
+	void encodeAlphaBlock(const unsigned char texels[16 * 4], unsigned char* block)
+	{
+		int alpha0 = 0, alpha1 = 255;
+		for (auto i = 0; i < 16; i++)
+		{
+			alpha0 = std::max(alpha0, int(texels[i * 4 + 3]));
+			alpha1 = std::min(alpha1, int(texels[i * 4 + 3]));
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			int palette[8] = { alpha0, alpha1 };
+			for (auto index = 2; index < 8; index++) {
+				palette[index] = ((8 - index) * alpha0 + (index - 1) * alpha1) / 7;
+			}
+			for (auto i = 0; i < 16; i++)
+			{
+				auto bestIndex = 0, bestDistance = INT32_MAX;
+				for (auto index = 0; index < 8; index++)
+				{
+					const auto distance = std::abs(texels[i * 4 + 3] - palette[index]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+				indices |= uint64_t(bestIndex) << (i * 3);
+			}
+		}
+
+		block[0] = (unsigned char)alpha0;
+		block[1] = (unsigned char)alpha1;
+		for (auto i = 0; i < 6; i++) {
+			block[2 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+	// Blocks of one level, texels outside the level repeat its last row and column
+	std::vector<unsigned char> compressLevel(const Level& level, uint32_t format)
+	{
+		const auto blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+		const auto blockSize = getBlockSize(format);
+		std::vector<unsigned char> blocks(size_t(blocksX) * blocksY * blockSize);
+		unsigned char texels[16 * 4];
+		for (auto blockY = 0; blockY < blocksY; blockY++)
+		{
+			for (auto blockX = 0; blockX < blocksX; blockX++)
+			{
+				for (auto i = 0; i < 16; i++)
+				{
+					const auto x = std::min(blockX * 4 + i % 4, level.width - 1);
+					const auto y = std::min(blockY * 4 + i / 4, level.height - 1);
+					memcpy(texels + i * 4, &level.pixels[(size_t(y) * level.width + x) * 4], 4);
+				}
+				auto* block = &blocks[(size_t(blockY) * blocksX + blockX) * blockSize];
+				if (format == BAKED_TEXTURE_BC3)
+				{
+					encodeAlphaBlock(texels, block);
+					block += 8;
+				}
+				encodeColorBlock(texels, block);
+			}
+		}
+		return blocks;
+	}
+
+} // namespace
+
+bool bakeTexture(const char* imagePath, const char* bakedPath)
+{
+	// flipped the same way loadTexture does, so that texture coordinates do not change
+	int width, height, numComponents;
+	stbi_set_flip_vertically_on_load(true);
+	auto* data = stbi_load(imagePath, &width, &height, &numComponents, 4);
+	if (data == nullptr)
+	{
+		std::cerr << "Could not load image " << imagePath << " to bake!" << std::endl;
+		return false;
+	}
+	Level level = { width, height, std::vector<unsigned char>(data, data + size_t(width) * height * 4) };
+	stbi_image_free(data);
+
+	auto opaque = true;
+	for (size_t i = 3; i < level.pixels.size() && opaque; i += 4) {
+		opaque = level.pixels[i] == 255;
+	}
+
+	TextureFileHeader header;
+	memcpy(header.magic, TEXTURE_FILE_MAGIC, sizeof(TEXTURE_FILE_MAGIC));
+	header.version = TEXTURE_FILE_VERSION;
+	header.format = opaque ? BAKED_TEXTURE_BC1 : BAKED_TEXTURE_BC3;
+	header.width = uint32_t(width);
+	header.height = uint32_t(height);
+	header.numLevels = 0;
+
+	// Whole mip chain down to 1x1
+	std::vector<TextureFileLevel> levelRecords;
+	std::vector<std::vector<unsigned char>> levelBlocks;
+	auto offset = uint32_t(sizeof(header));
+	while (true)
+	{
+		levelBlocks.push_back(compressLevel(level, header.format));
+		levelRecords.push_back({ 0, uint32_t(levelBlocks.back().size()), uint32_t(level.width), uint32_t(level.height) });
+		if (level.width == 1 && level.height == 1) {
+			break;
+		}
+		level = downsample(level);
+	}
+	header.numLevels = uint32_t(levelRecords.size());
+	offset += header.numLevels * uint32_t(sizeof(TextureFileLevel));
+	for (auto& record : levelRecords)
+	{
+		record.offset = offset;
+		offset += record.size;
+	}
+
+	std::ofstream file(bakedPath, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Could not write baked texture " << bakedPath << "!" << std::endl;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(levelRecords.data()), levelRecords.size() * sizeof(TextureFileLevel));
+	for (const auto& blocks : levelBlocks) {
+		file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+	}
+	return file.good();
+}
+
+std::string getBakedTexturePath(const char* imagePath)
+{
+	return std::filesystem::path(imagePath).replace_extension(".texb").string();
+}
+
+bool isBakedTextureUpToDate(const char* imagePath, const std::string& bakedPath)
+{
+	std::error_code error;
+	const auto bakedTime = std::filesystem::last_write_time(bakedPath, error);
+	if (error) {
+		return false;
+	}
+	// the image may not be shipped at all, only its baked texture
+	const auto imageTime = std::filesystem::last_write_time(imagePath, error);
+	return error || bakedTime >= imageTime;
+}
+
+GLenum readBakedTexture(const MappedFile& file, const char* bakedPath, const TextureOptions& options, std::vector<BakedTextureLevel>& levels)
+{
+	const auto data = file.getData();
+	const auto size = file.getSize();
+	TextureFileHeader header;
+	if (size < sizeof(header))
+	{
+		std::cerr << "Baked texture " << bakedPath << " is truncated!" << std::endl;
+		return 0;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, TEXTURE_FILE_MAGIC, sizeof(TEXTURE_FILE_MAGIC)) != 0 || header.version != TEXTURE_FILE_VERSION
+		|| header.format > BAKED_TEXTURE_BC3 || header.numLevels == 0 || header.numLevels > MAX_LEVELS
+		|| size < sizeof(header) + header.numLevels * sizeof(TextureFileLevel))
+	{
+		std::cerr << "File " << bakedPath << " is not a baked texture of version " << TEXTURE_FILE_VERSION << "!" << std::endl;
+		return 0;
+	}
+
+	TextureFileLevel records[MAX_LEVELS];
+	memcpy(records, data + sizeof(header), header.numLevels * sizeof(TextureFileLevel));
+	levels.clear();
+	for (uint32_t i = 0; i < header.numLevels; i++)
+	{
+		const auto& record = records[i];
+		const auto expectedSize = size_t((record.width + 3) / 4) * ((record.height + 3) / 4) * getBlockSize(header.format);
+		if (record.size != expectedSize || record.offset > size || size - record.offset < record.size)
+		{
+			std::cerr << "Baked texture " << bakedPath << " is corrupted!" << std::endl;
+			levels.clear();
+			return 0;
+		}
+		levels.push_back({ GLsizei(record.width), GLsizei(record.height), GLsizei(record.size), data + record.offset });
+	}
+
+	if (header.format == BAKED_TEXTURE_BC1) {
+		return options.srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+	return options.srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+unsigned int loadBakedTexture(const char* bakedPath, const TextureOptions& options)
+{
+	if (!TextureStorage::isS3TCAvailable()) {
+		return 0;
+	}
+
+	MappedFile file;
+	std::vector<BakedTextureLevel> levels;
+	if (!file.open(bakedPath)) {
+		return 0;
+	}
+	const auto internalFormat = readBakedTexture(file, bakedPath, options, levels);
+	if (internalFormat == 0) {
+		return 0;
+	}
+
+	// Blocks go to the driver straight from the mapping, there is nothing to decode or filter
+	const auto numLevels = options.mipmaps ? levels.size() : 1;
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	GL_LABEL(GL_TEXTURE, textureID, bakedPath);
+	if (TextureStorage::isImmutable())
+	{
+		TextureStorage::allocate(internalFormat, levels[0].width, levels[0].height, GLsizei(numLevels));
+		for (size_t i = 0; i < numLevels; i++)
+		{
+			const auto& level = levels[i];
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, GLint(i), 0, 0, level.width, level.height, internalFormat, level.size, level.blocks);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < numLevels; i++)
+		{
+			const auto& level = levels[i];
+			glCompressedTexImage2D(GL_TEXTURE_2D, GLint(i), internalFormat, level.width, level.height, 0, level.size, level.blocks);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(numLevels) - 1);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return textureID;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+// Project
+#include "Texture.h"
+
+class MappedFile;
+
+/** Block compression of a baked texture. */
+enum BakedTextureFormat
+{
+	BAKED_TEXTURE_BC1 = 0, //! DXT1, opaque RGB in 8 bytes per 4x4 block
+	BAKED_TEXTURE_BC3 = 1 //! DXT5, RGB with interpolated alpha in 16 bytes per 4x4 block
+};
+
+/** One mip level of a baked texture, its blocks are in the mapped file. */
+struct BakedTextureLevel
+{
+	GLsizei width;
+	GLsizei height;
+	GLsizei size; //! Bytes of all blocks of the level
+	const unsigned char* blocks;
+};
+
+/** \brief Compresses an image file into a baked texture file - all mip levels box filtered and block compressed
+*   (BC3 if the image has any transparency, BC1 otherwise), so that loading it needs neither decoding nor mipmap generation.
+*   \return True if the baked texture has been written, false otherwise.
+*/
+bool bakeTexture(const char* imagePath, const char* bakedPath);
+
+/** \brief Gets path of the baked texture belonging to given image (same directory and name, ".texb" extension). */
+std::string getBakedTexturePath(const char* imagePath);
+
+/** \brief Checks, if baked texture exists and is not older than the image it was baked from. */
+bool isBakedTextureUpToDate(const char* imagePath, const std::string& bakedPath);
+
+/** \brief Reads level records of a mapped baked texture, checking them against the file.
+*   \param levels Receives all levels, largest first
+*   \return Compressed internal format of the levels (sRGB one if the options say so), 0 if the file is not a valid baked texture.
+*/
+GLenum readBakedTexture(const MappedFile& file, const char* bakedPath, const TextureOptions& options, std::vector<BakedTextureLevel>& levels);
+
+/** \brief Loads baked texture - the file is mapped and its blocks are uploaded as they are, one level after another.
+*   \return OpenGL texture ID, 0 if the file is not a valid baked texture or the driver lacks S3TC support.
+*/
+unsigned int loadBakedTexture(const char* bakedPath, const TextureOptions& options = TextureOptions());
@@ -0,0 +1,357 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+// GLM
+#include <glm/gtc/matrix_transform.hpp>
+
+// Project
+#include "Benchmark.h"
+#include "NormalMatrix.h"
+
+namespace {
+
+	enum UniformType
+	{
+		UNIFORM_FLOAT,
+		UNIFORM_VEC3,
+		UNIFORM_MAT4
+	};
+
+	struct BenchmarkUniform
+	{
+		std::string name;
+		UniformType type;
+		UniformHandle handle;
+	};
+
+	/** Runs the set function given number of times, returns nanoseconds per single uniform update. */
+	template<typename SetFunction>
+	double measureUniforms(int iterations, size_t numUniforms, SetFunction setAll)
+	{
+		glFinish();
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			setAll();
+		}
+		glFinish();
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / (double(iterations) * double(numUniforms));
+	}
+
+} // namespace
+
+CameraPath::CameraPath()
+{
+	// Orbit around the objects, with a dive closer to the pin and the battery, then back to start
+	const glm::vec3 sceneCenter(2.5f, 0.0f, 0.0f);
+	_keyframes = {
+		{ 0.0f, glm::vec3(1.0f, 3.0f, 5.0f), sceneCenter },
+		{ 2.0f, glm::vec3(7.0f, 2.5f, 4.0f), sceneCenter },
+		{ 4.0f, glm::vec3(8.0f, 2.0f, -3.0f), glm::vec3(4.0f, 0.0f, -2.0f) },
+		{ 6.0f, glm::vec3(2.0f, 3.5f, -6.0f), sceneCenter },
+		{ 8.0f, glm::vec3(-3.0f, 2.0f, 0.0f), glm::vec3(1.5f, 0.3f, 1.0f) },
+		{ 10.0f, glm::vec3(3.0f, 1.2f, 4.0f), glm::vec3(4.0f, 0.5f, 3.0f) },
+		{ 12.0f, glm::vec3(1.0f, 3.0f, 5.0f), sceneCenter }
+	};
+}
+
+void CameraPath::apply(Camera& camera, float time) const
+{
+	time = std::fmod(time, getDuration());
+
+	size_t next = 1;
+	while (next + 1 < _keyframes.size() && _keyframes[next].time < time) {
+		next++;
+	}
+	const auto& a = _keyframes[next - 1];
+	const auto& b = _keyframes[next];
+	const auto t = glm::clamp((time - a.time) / (b.time - a.time), 0.0f, 1.0f);
+
+	const auto position = glm::mix(a.position, b.position, t);
+	const auto direction = glm::normalize(glm::mix(a.target, b.target, t) - position);
+
+	camera.Position = position;
+	camera.Yaw = glm::degrees(std::atan2(direction.z, direction.x));
+	camera.Pitch = glm::degrees(std::asin(direction.y));
+	camera.ProcessMouseMovement(0.0f, 0.0f); // Only recalculates camera vectors
+}
+
+float CameraPath::getDuration() const
+{
+	return _keyframes.back().time;
+}
+
+GpuTimer::~GpuTimer()
+{
+	if (_isCreated) {
+		glDeleteQueries(NUM_QUERIES, _queries);
+	}
+}
+
+void GpuTimer::begin(std::vector<double>& resultsMs)
+{
+	if (!_isCreated)
+	{
+		glGenQueries(NUM_QUERIES, _queries);
+		_isCreated = true;
+	}
+
+	// Read whatever has finished, the ring being full means we must wait for the oldest query
+	collect(resultsMs, false);
+	if (_numPending == NUM_QUERIES)
+	{
+		collect(resultsMs, true);
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, _queries[_next]);
+}
+
+void GpuTimer::end()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	_next = (_next + 1) % NUM_QUERIES;
+	_numPending++;
+}
+
+void GpuTimer::finish(std::vector<double>& resultsMs)
+{
+	while (_numPending > 0) {
+		collect(resultsMs, true);
+	}
+}
+
+void GpuTimer::collect(std::vector<double>& resultsMs, bool wait)
+{
+	// Results come in the order queries have been issued
+	while (_numPending > 0)
+	{
+		const auto oldest = _queries[(_next - _numPending + NUM_QUERIES) % NUM_QUERIES];
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available && !wait) {
+			return;
+		}
+
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(oldest, GL_QUERY_RESULT, &elapsedNs);
+		resultsMs.push_back(double(elapsedNs) / 1.0e6);
+		_numPending--;
+
+		if (wait) {
+			return;
+		}
+	}
+}
+
+double BenchmarkReport::percentile(std::vector<double> samples, double percent)
+{
+	if (samples.empty()) {
+		return 0.0;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	const auto rank = size_t(std::ceil(percent / 100.0 * double(samples.size())));
+	return samples[std::min(std::max(rank, size_t(1)), samples.size()) - 1];
+}
+
+void BenchmarkReport::writeJson(std::ostream& os, const char* scenePath, int width, int height, float timestep) const
+{
+	auto writeTimes = [&os](const char* name, const std::vector<double>& samples)
+	{
+		os << "  \"" << name << "\": { "
+			<< "\"p50\": " << percentile(samples, 50.0) << ", "
+			<< "\"p95\": " << percentile(samples, 95.0) << ", "
+			<< "\"p99\": " << percentile(samples, 99.0) << ", "
+			<< "\"max\": " << percentile(samples, 100.0) << ", "
+			<< "\"samples\": " << samples.size() << " }";
+	};
+
+	os << "{\n";
+	os << "  \"scene\": \"";
+	for (auto c = scenePath; *c != '\0'; c++) {
+		os << (*c == '"' || *c == '\\' ? "\\" : "") << *c;
+	}
+	os << "\",\n";
+	os << "  \"width\": " << width << ",\n";
+	os << "  \"height\": " << height << ",\n";
+	os << "  \"timestep\": " << timestep << ",\n";
+	os << "  \"renderer\": \"" << renderer << "\",\n";
+	os << "  \"frames\": " << cpuFrameTimesMs.size() << ",\n";
+	writeTimes("cpu_frame_ms", cpuFrameTimesMs);
+	os << ",\n";
+	writeTimes("gpu_frame_ms", gpuFrameTimesMs);
+	os << ",\n";
+	const auto numFrames = double(std::max(cpuFrameTimesMs.size(), size_t(1)));
+	os << "  \"draw_calls_per_frame\": " << double(drawCalls) / numFrames << ",\n";
+	os << "  \"triangles_per_frame\": " << double(triangles) / numFrames << "\n";
+	os << "}" << std::endl;
+}
+
+void benchmarkUniforms(Shader& shader, int iterations, std::ostream& os)
+{
+	// Every uniform of supported type the program has outside of uniform blocks
+	std::vector<BenchmarkUniform> uniforms;
+	GLint numUniforms = 0, maxNameLength = 0;
+	glGetProgramiv(shader.ID, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(shader.ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+	for (GLint i = 0; i < numUniforms; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = GL_NONE;
+		glGetActiveUniform(shader.ID, GLuint(i), GLsizei(nameBuffer.size()), &nameLength, &size, &type, nameBuffer.data());
+
+		BenchmarkUniform uniform;
+		uniform.name.assign(nameBuffer.data(), nameLength);
+		uniform.handle = shader.getUniform(uniform.name);
+		if (!uniform.handle.isValid()) {
+			continue;
+		}
+
+		if (type == GL_FLOAT) {
+			uniform.type = UNIFORM_FLOAT;
+		}
+		else if (type == GL_FLOAT_VEC3) {
+			uniform.type = UNIFORM_VEC3;
+		}
+		else if (type == GL_FLOAT_MAT4) {
+			uniform.type = UNIFORM_MAT4;
+		}
+		else {
+			continue;
+		}
+		uniforms.push_back(uniform);
+	}
+	if (uniforms.empty())
+	{
+		os << "{ \"uniforms\": 0 }" << std::endl;
+		return;
+	}
+
+	const glm::vec3 vec3Value(0.5f);
+	const glm::mat4 mat4Value(1.0f);
+	shader.use();
+
+	const auto uncachedNs = measureUniforms(iterations, uniforms.size(), [&]()
+	{
+		for (const auto& uniform : uniforms)
+		{
+			const auto location = glGetUniformLocation(shader.ID, uniform.name.c_str());
+			switch (uniform.type)
+			{
+			case UNIFORM_FLOAT: glUniform1f(location, 0.5f); break;
+			case UNIFORM_VEC3: glUniform3fv(location, 1, &vec3Value[0]); break;
+			case UNIFORM_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, &mat4Value[0][0]); break;
+			}
+		}
+	});
+
+	const auto cachedNameNs = measureUniforms(iterations, uniforms.size(), [&]()
+	{
+		for (const auto& uniform : uniforms)
+		{
+			switch (uniform.type)
+			{
+			case UNIFORM_FLOAT: shader.setFloat(uniform.name, 0.5f); break;
+			case UNIFORM_VEC3: shader.setVec3(uniform.name, vec3Value); break;
+			case UNIFORM_MAT4: shader.setMat4(uniform.name, mat4Value); break;
+			}
+		}
+	});
+
+	const auto handleNs = measureUniforms(iterations, uniforms.size(), [&]()
+	{
+		for (const auto& uniform : uniforms)
+		{
+			switch (uniform.type)
+			{
+			case UNIFORM_FLOAT: shader.setFloat(uniform.handle, 0.5f); break;
+			case UNIFORM_VEC3: shader.setVec3(uniform.handle, vec3Value); break;
+			case UNIFORM_MAT4: shader.setMat4(uniform.handle, mat4Value); break;
+			}
+		}
+	});
+
+	os << "{\n";
+	os << "  \"uniforms\": " << uniforms.size() << ",\n";
+	os << "  \"iterations\": " << iterations << ",\n";
+	os << "  \"ns_per_uniform\": { "
+		<< "\"glGetUniformLocation\": " << uncachedNs << ", "
+		<< "\"cached_name\": " << cachedNameNs << ", "
+		<< "\"handle\": " << handleNs << " }\n";
+	os << "}" << std::endl;
+}
+
+void benchmarkNormalMatrix(LightingShaderCache& shaders, LightingPermutation permutation, GLuint vao, const DrawCommand& draw,
+	int iterations, std::ostream& os)
+{
+	const int NUM_ROUNDS = 7;
+
+	permutation.legacyNormalMatrix = false;
+	auto& cpuProgram = *shaders.get(permutation);
+	permutation.legacyNormalMatrix = true;
+	auto& legacyProgram = *shaders.get(permutation);
+
+	// Rotated and non-uniformly scaled, so that the legacy path really has to invert something
+	const auto model = glm::scale(glm::rotate(glm::mat4(1.0f), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(1.0f, 2.0f, 1.0f));
+	const auto normalMatrix = computeNormalMatrix(model);
+
+	// Only vertex processing is measured, rasterization and fragment shading are discarded
+	glBindVertexArray(vao);
+	glEnable(GL_RASTERIZER_DISCARD);
+	if (draw.primitiveRestart)
+	{
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(draw.primitiveRestartIndex);
+	}
+
+	// Rounds alternate between the programs, so that clock changes of the GPU affect both the same way
+	GpuTimer cpuTimer, legacyTimer;
+	std::vector<double> cpuRoundsMs, legacyRoundsMs;
+	for (auto round = 0; round < NUM_ROUNDS; round++)
+	{
+		for (auto legacy : { false, true })
+		{
+			auto& program = legacy ? legacyProgram : cpuProgram;
+			auto& timer = legacy ? legacyTimer : cpuTimer;
+			program.use();
+			program.setMat4(program.getUniform("model"), model);
+			program.setMat3(program.getUniform("normalMatrix"), normalMatrix);
+
+			timer.begin(legacy ? legacyRoundsMs : cpuRoundsMs);
+			for (auto i = 0; i < iterations; i++) {
+				draw.execute();
+			}
+			timer.end();
+		}
+	}
+	cpuTimer.finish(cpuRoundsMs);
+	legacyTimer.finish(legacyRoundsMs);
+
+	if (draw.primitiveRestart) {
+		glDisable(GL_PRIMITIVE_RESTART);
+	}
+	glDisable(GL_RASTERIZER_DISCARD);
+	glBindVertexArray(0);
+
+	const auto usPerDraw = [iterations](const std::vector<double>& roundsMs) {
+		return BenchmarkReport::percentile(roundsMs, 50.0) * 1000.0 / iterations;
+	};
+	const auto cpuUs = usPerDraw(cpuRoundsMs);
+	const auto legacyUs = usPerDraw(legacyRoundsMs);
+
+	os << "{\n";
+	os << "  \"instanced\": " << (permutation.instanced ? "true" : "false") << ",\n";
+	os << "  \"instances\": " << draw.numInstances << ",\n";
+	os << "  \"triangles_per_draw\": " << draw.getNumTriangles() << ",\n";
+	os << "  \"iterations\": " << iterations << ",\n";
+	os << "  \"gpu_us_per_draw\": { "
+		<< "\"per_vertex_inverse\": " << legacyUs << ", "
+		<< "\"cpu_normal_matrix\": " << cpuUs << " },\n";
+	os << "  \"vertex_stage_saving_percent\": " << (legacyUs > 0.0 ? 100.0 * (legacyUs - cpuUs) / legacyUs : 0.0) << "\n";
+	os << "}" << std::endl;
+}
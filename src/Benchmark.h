@@ -0,0 +1,117 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <glad/glad.h>
+
+// Project
+#include "camera.h"
+#include "DrawCommand.h"
+#include "LightingShaders.h"
+#include "shader.h"
+
+/**
+  Scripted camera path - keyframes of position and look-at target, linearly interpolated and looped,
+  so that every benchmark run sees exactly the same frames.
+*/
+class CameraPath
+{
+public:
+	struct Keyframe
+	{
+		float time; //! Time of the keyframe in seconds
+		glm::vec3 position; //! Camera position
+		glm::vec3 target; //! Point the camera looks at
+	};
+
+	/** \brief Creates the default path around the default scene. */
+	CameraPath();
+
+	/** \brief Moves and turns the camera to where the path is at given time. */
+	void apply(Camera& camera, float time) const;
+
+	/** \brief Gets duration of one loop of the path, in seconds. */
+	float getDuration() const;
+
+private:
+	std::vector<Keyframe> _keyframes; // Sorted by time, first one at time 0
+};
+
+/**
+  GPU time of frames measured by GL_TIME_ELAPSED queries. Queries are kept in a ring and read only when
+  their result is available, so that measuring never stalls the pipeline.
+*/
+class GpuTimer
+{
+public:
+	static const int NUM_QUERIES = 8; //! Frames that can be in flight before the oldest result is waited for
+
+	GpuTimer() = default;
+	~GpuTimer();
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	/** \brief Starts measuring a frame, collects results of finished frames into given vector (in ms). */
+	void begin(std::vector<double>& resultsMs);
+
+	/** \brief Stops measuring the current frame. */
+	void end();
+
+	/** \brief Waits for all pending queries and collects their results (in ms). */
+	void finish(std::vector<double>& resultsMs);
+
+private:
+	GLuint _queries[NUM_QUERIES] = {}; //! Query ring
+	int _next = 0; //! Query to be used for next frame
+	int _numPending = 0; //! Queries issued, but not read yet
+	bool _isCreated = false; //! Flag telling, if queries have been generated
+
+	void collect(std::vector<double>& resultsMs, bool wait);
+};
+
+/**
+  Measured frames of one benchmark run, reported as percentiles in JSON.
+*/
+class BenchmarkReport
+{
+public:
+	std::vector<double> cpuFrameTimesMs; //! CPU time spent on every measured frame
+	std::vector<double> gpuFrameTimesMs; //! GPU time of every measured frame
+	uint64_t drawCalls = 0; //! Draw calls of all measured frames, reported per frame
+	uint64_t triangles = 0; //! Triangles of all measured frames, reported per frame
+	const char* renderer = "forward"; //! Renderer path the frames were drawn with ("forward" or "deferred")
+
+	/** \brief Gets percentile (0..100) of given samples, by nearest rank. */
+	static double percentile(std::vector<double> samples, double percent);
+
+	/** \brief Writes the report as a JSON object. */
+	void writeJson(std::ostream& os, const char* scenePath, int width, int height, float timestep) const;
+};
+
+/** \brief Microbenchmark of setting all float, vec3 and mat4 uniforms of a program (outside of uniform blocks) -
+*   by name through glGetUniformLocation on every call (how Shader used to work), by name through the location cache,
+*   and by cached handle.
+*   \param shader Program to set uniforms of, it gets bound
+*   \param iterations How many times all the uniforms are set with each method
+*   \param os Stream receiving JSON with nanoseconds per uniform of each method
+*/
+void benchmarkUniforms(Shader& shader, int iterations, std::ostream& os);
+
+/** \brief GPU time of the vertex stage with the normal matrix computed once on the CPU, against the old inverse per vertex
+*   (LEGACY_NORMAL_MATRIX permutation). Draws are issued with rasterization discarded, so that vertex processing is all that's measured.
+*   \param shaders Cache to get both permutations of the program from
+*   \param permutation Permutation to compare, instanced must match the VAO (legacyNormalMatrix is ignored)
+*   \param vao VAO of the mesh to draw
+*   \param draw Draw call of the mesh
+*   \param iterations How many draws are measured with each program in every round
+*   \param os Stream receiving JSON with GPU microseconds per draw of both programs
+*/
+void benchmarkNormalMatrix(LightingShaderCache& shaders, LightingPermutation permutation, GLuint vao, const DrawCommand& draw,
+	int iterations, std::ostream& os);
@@ -0,0 +1,259 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// Project
+#include "ClusteredLighting.h"
+#include "GLDebug.h"
+
+namespace {
+
+	// Light contributions below this are invisible in an 8-bit framebuffer
+	const float LIGHT_CUTOFF = 1.0f / 256.0f;
+
+	// Influence stops at the far plane of the camera (as shadows do), so that lights without attenuation get a finite radius
+	const float MAX_INFLUENCE_RADIUS = 100.0f;
+
+	// Texels per light in the lights buffer: position + radius, ambient + constant, diffuse + linear, specular + quadratic
+	const int TEXELS_PER_LIGHT = 4;
+
+	int clampTile(float value, int size)
+	{
+		// converting infinity or NaN to int is undefined
+		if (!std::isfinite(value)) {
+			return value > 0.0f ? size - 1 : 0;
+		}
+		return std::min(std::max(int(std::floor(value)), 0), size - 1);
+	}
+
+} // namespace
+
+ClusteredLighting::~ClusteredLighting()
+{
+	deleteResources();
+}
+
+void ClusteredLighting::create()
+{
+	deleteResources();
+
+	static const GLenum FORMATS[NUM_BUFFERS] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	static const char* LABELS[NUM_BUFFERS] = { "Cluster lights", "Cluster grid", "Cluster light indices" };
+	glGenBuffers(NUM_BUFFERS, _buffers);
+	glGenTextures(NUM_BUFFERS, _textures);
+	for (auto i = 0; i < NUM_BUFFERS; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, _buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, FORMATS[i], _buffers[i]);
+		GL_LABEL(GL_BUFFER, _buffers[i], LABELS[i]);
+		GL_LABEL(GL_TEXTURE, _textures[i], LABELS[i]);
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	_clusterUniforms.create("ClusterData", CLUSTER_BLOCK_BINDING, sizeof(ClusterBlock));
+	_grid.resize(NUM_CLUSTERS);
+}
+
+void ClusteredLighting::setLights(const Scene& scene)
+{
+	std::vector<glm::vec4> texels;
+	texels.reserve(size_t(scene.getNumLights()) * TEXELS_PER_LIGHT);
+	_lightSpheres.clear();
+	for (uint32_t i = 0; i < scene.getNumLights(); i++)
+	{
+		const auto& light = scene.getLight(i);
+		const auto radius = computeInfluenceRadius(light);
+		_lightSpheres.emplace_back(light.position, radius);
+		texels.emplace_back(light.position, radius);
+		texels.emplace_back(light.ambient, light.constant);
+		texels.emplace_back(light.diffuse, light.linear);
+		texels.emplace_back(light.specular, light.quadratic);
+	}
+	uploadBuffer(LIGHTS_BUFFER, texels.data(), texels.size() * sizeof(glm::vec4), sizeof(glm::vec4) * TEXELS_PER_LIGHT);
+	_stats.numLights = uint32_t(_lightSpheres.size());
+}
+
+void ClusteredLighting::update(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane, int viewportWidth, int viewportHeight)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	// Pass 1 - clusters of every light, counted per cluster
+	_lightRanges.resize(_lightSpheres.size());
+	std::fill(_grid.begin(), _grid.end(), glm::uvec2(0));
+	_stats.numVisibleLights = 0;
+	for (size_t i = 0; i < _lightSpheres.size(); i++)
+	{
+		const auto& sphere = _lightSpheres[i];
+		auto& range = _lightRanges[i];
+		if (!findClusters(glm::vec3(view * glm::vec4(glm::vec3(sphere), 1.0f)), sphere.w, projection, nearPlane, farPlane, range))
+		{
+			range.minZ = 1;
+			range.maxZ = 0;
+			continue;
+		}
+
+		_stats.numVisibleLights++;
+		for (auto z = range.minZ; z <= range.maxZ; z++)
+		{
+			for (auto y = range.minY; y <= range.maxY; y++)
+			{
+				for (auto x = range.minX; x <= range.maxX; x++) {
+					_grid[x + GRID_SIZE_X * (y + GRID_SIZE_Y * z)].y++;
+				}
+			}
+		}
+	}
+
+	// Offsets of the index lists, then counts are reset and used as fill positions
+	uint32_t offset = 0;
+	_stats.maxLightsPerCluster = 0;
+	for (auto& cluster : _grid)
+	{
+		cluster.x = offset;
+		offset += cluster.y;
+		_stats.maxLightsPerCluster = std::max(_stats.maxLightsPerCluster, cluster.y);
+		cluster.y = 0;
+	}
+
+	// Pass 2 - light indices of every cluster
+	_lightIndices.resize(offset);
+	for (size_t i = 0; i < _lightRanges.size(); i++)
+	{
+		const auto& range = _lightRanges[i];
+		for (auto z = range.minZ; z <= range.maxZ; z++)
+		{
+			for (auto y = range.minY; y <= range.maxY; y++)
+			{
+				for (auto x = range.minX; x <= range.maxX; x++)
+				{
+					auto& cluster = _grid[x + GRID_SIZE_X * (y + GRID_SIZE_Y * z)];
+					_lightIndices[cluster.x + cluster.y++] = uint32_t(i);
+				}
+			}
+		}
+	}
+	_stats.numLightIndices = offset;
+
+	uploadBuffer(GRID_BUFFER, _grid.data(), _grid.size() * sizeof(glm::uvec2), sizeof(glm::uvec2));
+	uploadBuffer(LIGHT_INDICES_BUFFER, _lightIndices.data(), _lightIndices.size() * sizeof(uint32_t), sizeof(uint32_t));
+
+	// Depth slices are exponential, slice = log(depth) * scale + bias puts near plane at 0 and far plane at GRID_SIZE_Z
+	const auto logDepthRange = std::log(farPlane / nearPlane);
+	ClusterBlock block;
+	block.gridSize = glm::uvec4(GRID_SIZE_X, GRID_SIZE_Y, GRID_SIZE_Z, _stats.numLights);
+	block.gridScale = glm::vec4(float(GRID_SIZE_X) / float(viewportWidth), float(GRID_SIZE_Y) / float(viewportHeight),
+		float(GRID_SIZE_Z) / logDepthRange, -float(GRID_SIZE_Z) * std::log(nearPlane) / logDepthRange);
+	_clusterUniforms.update(&block);
+
+	const GLint units[NUM_BUFFERS] = { CLUSTER_LIGHTS_TEXTURE_UNIT, CLUSTER_GRID_TEXTURE_UNIT, CLUSTER_LIGHT_INDICES_TEXTURE_UNIT };
+	for (auto i = 0; i < NUM_BUFFERS; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + units[i]);
+		glBindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	const std::chrono::duration<double, std::milli> buildTime = std::chrono::steady_clock::now() - start;
+	_stats.buildTimeMs = buildTime.count();
+}
+
+const ClusteredLightingStats& ClusteredLighting::getStats() const
+{
+	return _stats;
+}
+
+void ClusteredLighting::printStats(std::ostream& os) const
+{
+	os << "Clustered lighting: " << _stats.numLights << " lights, " << _stats.numVisibleLights << " visible, "
+		<< GRID_SIZE_X << "x" << GRID_SIZE_Y << "x" << GRID_SIZE_Z << " clusters, " << _stats.numLightIndices << " light indices ("
+		<< double(_stats.numLightIndices) / NUM_CLUSTERS << " per cluster on average, " << _stats.maxLightsPerCluster << " at most), built in "
+		<< _stats.buildTimeMs << " ms" << std::endl;
+}
+
+void ClusteredLighting::deleteResources()
+{
+	if (_buffers[0] != 0)
+	{
+		glDeleteTextures(NUM_BUFFERS, _textures);
+		glDeleteBuffers(NUM_BUFFERS, _buffers);
+		std::fill(std::begin(_textures), std::end(_textures), 0);
+		std::fill(std::begin(_buffers), std::end(_buffers), 0);
+	}
+	_clusterUniforms.deleteBuffer();
+}
+
+float ClusteredLighting::computeInfluenceRadius(const SceneLightRecord& light)
+{
+	// Brightest channel of all terms, they are all attenuated the same way
+	const auto color = light.ambient + light.diffuse + light.specular;
+	const auto intensity = std::max(color.x, std::max(color.y, color.z));
+
+	// intensity / (constant + linear * d + quadratic * d^2) = cutoff
+	const auto c = light.constant - intensity / LIGHT_CUTOFF;
+	if (c >= 0.0f) {
+		return 0.0f;
+	}
+	if (light.quadratic > 0.0f) {
+		return std::min((-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic), MAX_INFLUENCE_RADIUS);
+	}
+	if (light.linear > 0.0f) {
+		return std::min(-c / light.linear, MAX_INFLUENCE_RADIUS);
+	}
+	return MAX_INFLUENCE_RADIUS;
+}
+
+bool ClusteredLighting::findClusters(const glm::vec3& center, float radius, const glm::mat4& projection, float nearPlane, float farPlane,
+	ClusterRange& range) const
+{
+	// Depth range of the sphere, cut to the frustum
+	const auto nearDepth = std::max(-center.z - radius, nearPlane);
+	const auto farDepth = std::min(-center.z + radius, farPlane);
+	if (radius <= 0.0f || nearDepth > farDepth) {
+		return false;
+	}
+
+	// Screen rectangle of the view space box around the sphere (within the depth range, so that all corners are in front
+	// of the camera) - the box is convex, so its projection is bounded by the projected corners
+	glm::vec2 minNdc(std::numeric_limits<float>::max()), maxNdc(-std::numeric_limits<float>::max());
+	for (auto corner = 0; corner < 8; corner++)
+	{
+		const glm::vec4 point((corner & 1) != 0 ? center.x + radius : center.x - radius, (corner & 2) != 0 ? center.y + radius : center.y - radius,
+			(corner & 4) != 0 ? -farDepth : -nearDepth, 1.0f);
+		const auto clip = projection * point;
+		const auto ndc = glm::vec2(clip) / clip.w;
+		minNdc = glm::min(minNdc, ndc);
+		maxNdc = glm::max(maxNdc, ndc);
+	}
+	if (!std::isfinite(minNdc.x) || !std::isfinite(minNdc.y) || !std::isfinite(maxNdc.x) || !std::isfinite(maxNdc.y)
+		|| maxNdc.x < -1.0f || maxNdc.y < -1.0f || minNdc.x > 1.0f || minNdc.y > 1.0f) {
+		return false;
+	}
+
+	const auto logDepthRange = std::log(farPlane / nearPlane);
+	range.minX = clampTile((minNdc.x * 0.5f + 0.5f) * GRID_SIZE_X, GRID_SIZE_X);
+	range.maxX = clampTile((maxNdc.x * 0.5f + 0.5f) * GRID_SIZE_X, GRID_SIZE_X);
+	range.minY = clampTile((minNdc.y * 0.5f + 0.5f) * GRID_SIZE_Y, GRID_SIZE_Y);
+	range.maxY = clampTile((maxNdc.y * 0.5f + 0.5f) * GRID_SIZE_Y, GRID_SIZE_Y);
+	range.minZ = clampTile(std::log(nearDepth / nearPlane) / logDepthRange * GRID_SIZE_Z, GRID_SIZE_Z);
+	range.maxZ = clampTile(std::log(farDepth / nearPlane) / logDepthRange * GRID_SIZE_Z, GRID_SIZE_Z);
+	return true;
+}
+
+void ClusteredLighting::uploadBuffer(BufferIndex index, const void* data, size_t byteSize, size_t elementSize)
+{
+	// Orphaned every time, the driver hands out fresh storage instead of waiting for draws still reading the old one
+	static const uint32_t EMPTY[4] = {};
+	glBindBuffer(GL_TEXTURE_BUFFER, _buffers[index]);
+	if (byteSize == 0) {
+		glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(elementSize), EMPTY, GL_STREAM_DRAW);
+	}
+	else {
+		glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(byteSize), data, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <glad/glad.h>
+
+// Project
+#include "Scene.h"
+#include "UniformBlocks.h"
+
+/** Texture units the clustered lighting buffers are bound to (units 0 and 1 belong to materials). */
+enum ClusterTextureUnit
+{
+	CLUSTER_LIGHTS_TEXTURE_UNIT = 2, //! "clusterLights" - 4 texels per light
+	CLUSTER_GRID_TEXTURE_UNIT = 3, //! "clusterGrid" - offset and count of light indices per cluster
+	CLUSTER_LIGHT_INDICES_TEXTURE_UNIT = 4 //! "clusterLightIndices" - light indices of all clusters one after another
+};
+
+/**
+  Statistics of the last built grid.
+*/
+struct ClusteredLightingStats
+{
+	uint32_t numLights = 0; //! Lights of the scene
+	uint32_t numVisibleLights = 0; //! Lights touching at least one cluster
+	uint32_t numLightIndices = 0; //! Light indices over all clusters
+	uint32_t maxLightsPerCluster = 0; //! Lights of the busiest cluster
+	double buildTimeMs = 0.0; //! CPU time of building and uploading the grid
+};
+
+/**
+  Clustered forward lighting - the view frustum is split into a grid of froxels (screen tiles times exponential
+  depth slices) and every froxel gets the list of lights whose influence sphere touches it, so that a fragment
+  evaluates only the lights of its own froxel, no matter how many the scene has. Lights, grid and index lists
+  live in texture buffers (OpenGL 3.3 has no SSBOs), the grid is rebuilt on the CPU every frame.
+*/
+class ClusteredLighting
+{
+public:
+	static const int GRID_SIZE_X = 16; //! Screen tiles horizontally
+	static const int GRID_SIZE_Y = 9; //! Screen tiles vertically
+	static const int GRID_SIZE_Z = 24; //! Depth slices between near and far plane
+	static const int NUM_CLUSTERS = GRID_SIZE_X * GRID_SIZE_Y * GRID_SIZE_Z;
+
+	ClusteredLighting() = default;
+	~ClusteredLighting();
+
+	ClusteredLighting(const ClusteredLighting&) = delete;
+	ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+	/** \brief Creates the texture buffers and the "ClusterData" uniform block. */
+	void create();
+
+	/** \brief Uploads all lights of the scene (lights are static, so this is done once). */
+	void setLights(const Scene& scene);
+
+	/** \brief Assigns lights to clusters of the current camera, uploads the grid and binds the texture buffers.
+	*   \param viewportWidth Width of the viewport in pixels, tiles are looked up by gl_FragCoord
+	*   \param viewportHeight Height of the viewport in pixels
+	*/
+	void update(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane, int viewportWidth, int viewportHeight);
+
+	/** \brief Gets statistics of the last update. */
+	const ClusteredLightingStats& getStats() const;
+
+	/** \brief Prints statistics of the last update in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+	/** \brief Deletes all buffers and textures (the OpenGL context must still exist). */
+	void deleteResources();
+
+	/** \brief Gets distance, at which contribution of the light drops below 1/256 (the light is cut off there),
+	*   at most the far plane of the camera - lights without attenuation reach that far.
+	*/
+	static float computeInfluenceRadius(const SceneLightRecord& light);
+
+private:
+	/** Clusters touched by one light, inclusive ranges. */
+	struct ClusterRange
+	{
+		int minX, maxX;
+		int minY, maxY;
+		int minZ, maxZ;
+	};
+
+	enum BufferIndex
+	{
+		LIGHTS_BUFFER = 0,
+		GRID_BUFFER = 1,
+		LIGHT_INDICES_BUFFER = 2,
+		NUM_BUFFERS = 3
+	};
+
+	GLuint _buffers[NUM_BUFFERS] = {}; // Texture buffer storage
+	GLuint _textures[NUM_BUFFERS] = {}; // Buffer textures sampling the storage
+	UniformBuffer _clusterUniforms; // "ClusterData" block
+
+	std::vector<glm::vec4> _lightSpheres; // World position and influence radius of every light
+	std::vector<ClusterRange> _lightRanges; // Clusters of every light in the current frame (empty range if not visible)
+	std::vector<glm::uvec2> _grid; // Offset and count of light indices per cluster
+	std::vector<uint32_t> _lightIndices; // Light indices of all clusters
+	ClusteredLightingStats _stats;
+
+	/** \brief Finds clusters touched by the light sphere given in view space, returns false if there are none. */
+	bool findClusters(const glm::vec3& center, float radius, const glm::mat4& projection, float nearPlane, float farPlane,
+		ClusterRange& range) const;
+
+	/** \brief Uploads the data into texture buffer of given index (at least one element, so the texture is never empty). */
+	void uploadBuffer(BufferIndex index, const void* data, size_t byteSize, size_t elementSize);
+};
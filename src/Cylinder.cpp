@@ -36,6 +36,11 @@ namespace static_meshes_3D {
 		return _height;
 	}
 
+	size_t Cylinder::getGPUByteSize() const
+	{
+		return _isInitialized ? size_t(getVertexByteSize()) * _numVerticesTotal : 0;
+	}
+
 	void Cylinder::initializeData()
 	{
 		if (_isInitialized) {
@@ -173,6 +178,20 @@ namespace static_meshes_3D {
 		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom);
 	}
 
+	void Cylinder::renderInstanced(int numInstances) const
+	{
+		if (!_isInitialized) {
+			return;
+		}
+
+		glBindVertexArray(_vao);
+
+		// Same three parts as in render, but every one of them for all instances at once
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, _numVerticesSide, numInstances);
+		glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide, _numVerticesTopBottom, numInstances);
+		glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom, numInstances);
+	}
+
 	void Cylinder::renderPoints() const
 	{
 		if (!_isInitialized) {
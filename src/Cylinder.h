@@ -14,6 +14,8 @@ namespace static_meshes_3D {
 
 		void render() const override;
 		void renderPoints() const override;
+		void renderInstanced(int numInstances) const override;
+		size_t getGPUByteSize() const override;
 
 		/**
 		 * Gets cylinder radius.
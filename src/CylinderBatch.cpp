@@ -0,0 +1,153 @@
+// STL
+#include <cstddef>
+#include <utility>
+
+// GLM
+#include <glm/gtc/matrix_transform.hpp>
+
+// Project
+#include "CylinderBatch.h"
+#include "NormalMatrix.h"
+
+namespace static_meshes_3D {
+
+	const int CylinderBatch::INSTANCE_MODEL_ATTRIBUTE_INDEX = 3;
+	const int CylinderBatch::INSTANCE_SCALE_ATTRIBUTE_INDEX = 7;
+	const int CylinderBatch::INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX = 8;
+	const int CylinderBatch::INSTANCE_TEXTURES_ATTRIBUTE_INDEX = 11;
+
+	CylinderBatch::CylinderBatch(std::shared_ptr<const IndexedCylinder> unitCylinder)
+		: _unitCylinder(std::move(unitCylinder))
+	{
+		_instancesVBO.createVBO(sizeof(Instance) * 64);
+
+		// Instance attributes live in our own VAO, next to vertex attributes of the unit cylinder
+		_vao = _unitCylinder->createSharedVAO();
+		_instancesVBO.bindVBO();
+		for (auto i = 0; i < 4; i++)
+		{
+			glEnableVertexAttribArray(INSTANCE_MODEL_ATTRIBUTE_INDEX + i);
+			glVertexAttribDivisor(INSTANCE_MODEL_ATTRIBUTE_INDEX + i, 1);
+		}
+		glEnableVertexAttribArray(INSTANCE_SCALE_ATTRIBUTE_INDEX);
+		glVertexAttribDivisor(INSTANCE_SCALE_ATTRIBUTE_INDEX, 1);
+		for (auto i = 0; i < 3; i++)
+		{
+			glEnableVertexAttribArray(INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX + i);
+			glVertexAttribDivisor(INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX + i, 1);
+		}
+		for (auto i = 0; i < 3; i++)
+		{
+			glEnableVertexAttribArray(INSTANCE_TEXTURES_ATTRIBUTE_INDEX + i);
+			glVertexAttribDivisor(INSTANCE_TEXTURES_ATTRIBUTE_INDEX + i, 1);
+		}
+		setInstanceAttributesPointers(0);
+	}
+
+	CylinderBatch::~CylinderBatch()
+	{
+		glDeleteVertexArrays(1, &_vao);
+		_instancesVBO.deleteVBO();
+	}
+
+	int CylinderBatch::addInstance(const glm::mat4& model, float radius, float height, const InstanceTextures& textures)
+	{
+		const auto scaledModel = glm::scale(model, glm::vec3(radius, height, radius));
+		_instances.push_back({ model, glm::vec2(radius, height), computeNormalMatrix(scaledModel), textures });
+		return int(_instances.size()) - 1;
+	}
+
+	void CylinderBatch::clearInstances()
+	{
+		_instances.clear();
+	}
+
+	void CylinderBatch::uploadInstances()
+	{
+		for (const auto& instance : _instances) {
+			_instancesVBO.addData(instance);
+		}
+
+		_instancesVBO.bindVBO();
+		_instancesVBO.uploadDataToGPU(GL_DYNAMIC_DRAW);
+		_numUploadedInstances = int(_instances.size());
+	}
+
+	void CylinderBatch::render() const
+	{
+		render(0, _numUploadedInstances);
+	}
+
+	void CylinderBatch::render(int firstInstance, int numInstances) const
+	{
+		if (numInstances <= 0 || firstInstance + numInstances > _numUploadedInstances) {
+			return;
+		}
+
+		// There is no base instance in OpenGL 3.3, so sub-ranges are rendered by moving instance pointers
+		glBindVertexArray(_vao);
+		setInstanceAttributesPointers(firstInstance);
+
+		auto drawCommand = _unitCylinder->getDrawCommand();
+		drawCommand.numInstances = numInstances;
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(drawCommand.primitiveRestartIndex);
+		drawCommand.execute();
+		glDisable(GL_PRIMITIVE_RESTART);
+
+		if (firstInstance != 0) {
+			setInstanceAttributesPointers(0);
+		}
+	}
+
+	int CylinderBatch::getSlices() const
+	{
+		return _unitCylinder->getSlices();
+	}
+
+	int CylinderBatch::getNumInstances() const
+	{
+		return _numUploadedInstances;
+	}
+
+	GLuint CylinderBatch::getVAO() const
+	{
+		return _vao;
+	}
+
+	DrawCommand CylinderBatch::getDrawCommand() const
+	{
+		auto result = _unitCylinder->getDrawCommand();
+		result.numInstances = _numUploadedInstances;
+		return result;
+	}
+
+	void CylinderBatch::setInstanceAttributesPointers(int firstInstance) const
+	{
+		const auto baseOffset = sizeof(Instance) * firstInstance;
+		glBindBuffer(GL_ARRAY_BUFFER, _instancesVBO.getBufferID());
+		for (auto i = 0; i < 4; i++)
+		{
+			const auto offset = baseOffset + offsetof(Instance, model) + sizeof(glm::vec4) * i;
+			glVertexAttribPointer(INSTANCE_MODEL_ATTRIBUTE_INDEX + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void*>(offset));
+		}
+
+		const auto scaleOffset = baseOffset + offsetof(Instance, radiusHeight);
+		glVertexAttribPointer(INSTANCE_SCALE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void*>(scaleOffset));
+
+		for (auto i = 0; i < 3; i++)
+		{
+			const auto offset = baseOffset + offsetof(Instance, normalMatrix) + sizeof(glm::vec3) * i;
+			glVertexAttribPointer(INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX + i, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void*>(offset));
+		}
+
+		const auto texturesOffset = baseOffset + offsetof(Instance, textures);
+		glVertexAttribPointer(INSTANCE_TEXTURES_ATTRIBUTE_INDEX, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+			reinterpret_cast<void*>(texturesOffset + offsetof(InstanceTextures, diffuseRect)));
+		glVertexAttribPointer(INSTANCE_TEXTURES_ATTRIBUTE_INDEX + 1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+			reinterpret_cast<void*>(texturesOffset + offsetof(InstanceTextures, specularRect)));
+		glVertexAttribPointer(INSTANCE_TEXTURES_ATTRIBUTE_INDEX + 2, 2, GL_FLOAT, GL_FALSE, sizeof(Instance),
+			reinterpret_cast<void*>(texturesOffset + offsetof(InstanceTextures, layers)));
+	}
+
+} // namespace static_meshes_3D
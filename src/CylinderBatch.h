@@ -0,0 +1,95 @@
+#pragma once
+
+// STL
+#include <memory>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "IndexedCylinder.h"
+
+namespace static_meshes_3D {
+
+	/**
+	* Where the material maps of an instance are in TextureArrays, so that instances of different materials
+	* can share one batch (read by the TEXTURE_ARRAYS permutation only).
+	*/
+	struct InstanceTextures
+	{
+		glm::vec4 diffuseRect = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f); //!< Scale (xy) and offset (zw) of the diffuse map within its layer
+		glm::vec4 specularRect = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f); //!< Scale (xy) and offset (zw) of the specular map within its layer
+		glm::vec2 layers = glm::vec2(0.0f); //!< Layers of the diffuse and specular maps
+	};
+
+	/**
+	* Draws many cylinders with the same number of slices using instanced rendering.
+	* One unit cylinder (radius 1, height 1) is uploaded once and all instances are drawn
+	* with a single instanced draw call, every instance supplies its model matrix and
+	* radius / height scale through an instance buffer. Batch has its own VAO, so several
+	* batches (e.g. one per texture) can share the same unit cylinder from the mesh cache.
+	*/
+	class CylinderBatch
+	{
+	public:
+		static const int INSTANCE_MODEL_ATTRIBUTE_INDEX; //!< First vertex attribute index of instance model matrix (3, takes 4 slots)
+		static const int INSTANCE_SCALE_ATTRIBUTE_INDEX; //!< Vertex attribute index of instance radius / height (7)
+		static const int INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX; //!< First vertex attribute index of instance normal matrix (8, takes 3 slots)
+		static const int INSTANCE_TEXTURES_ATTRIBUTE_INDEX; //!< First vertex attribute index of instance textures (11, diffuse rect, specular rect, layers)
+
+		/** \brief  Creates batch drawing given unit cylinder (radius 1, height 1). */
+		explicit CylinderBatch(std::shared_ptr<const IndexedCylinder> unitCylinder);
+		~CylinderBatch();
+
+		CylinderBatch(const CylinderBatch&) = delete;
+		CylinderBatch& operator=(const CylinderBatch&) = delete;
+
+		/** \brief  Adds a cylinder instance. Call uploadInstances() after adding all of them.
+		*   \return Index of the added instance.
+		*/
+		int addInstance(const glm::mat4& model, float radius, float height, const InstanceTextures& textures = InstanceTextures());
+
+		/** \brief  Removes all instances. */
+		void clearInstances();
+
+		/** \brief  Uploads instance data to the GPU, must be called after instances change. */
+		void uploadInstances();
+
+		/** \brief  Renders all uploaded instances. */
+		void render() const;
+
+		/** \brief  Renders a range of uploaded instances (e.g. ones sharing a texture). */
+		void render(int firstInstance, int numInstances) const;
+
+		/** \brief  Gets number of cylinder slices of this batch. */
+		int getSlices() const;
+
+		/** \brief  Gets number of instances uploaded to the GPU. */
+		int getNumInstances() const;
+
+		/** \brief  Gets VAO of this batch (unit cylinder and instance attributes). */
+		GLuint getVAO() const;
+
+		/** \brief  Gets the instanced draw call rendering all uploaded instances (with batch VAO bound). */
+		DrawCommand getDrawCommand() const;
+
+	private:
+		struct Instance
+		{
+			glm::mat4 model;
+			glm::vec2 radiusHeight;
+			glm::mat3 normalMatrix; // Of model with radius / height applied, so that shader needs no inverse
+			InstanceTextures textures;
+		};
+
+		std::shared_ptr<const IndexedCylinder> _unitCylinder; // Shared geometry of all instances
+		GLuint _vao = 0; // Unit cylinder buffers combined with instance attributes
+		VertexBufferObject _instancesVBO; // Per-instance model matrices and scales
+		std::vector<Instance> _instances; // Instances added so far
+		int _numUploadedInstances = 0; // How many instances are in the instance buffer
+
+		void setInstanceAttributesPointers(int firstInstance) const;
+	};
+
+} // namespace static_meshes_3D
@@ -0,0 +1,311 @@
+// STL
+#include <iostream>
+#include <vector>
+
+// Project
+#include "ClusteredLighting.h"
+#include "DeferredShading.h"
+#include "GLDebug.h"
+#include "ShapeGenerator.h"
+#include "UniformBlocks.h"
+
+namespace {
+
+	// Tessellation of the light volume, coarse is enough for a sphere that is only a stencil of the light's reach
+	const unsigned int VOLUME_TESSELLATION = 16;
+
+	// The tessellated sphere lies inside the unit sphere, it's scaled up so that its faces still enclose the influence radius
+	const float VOLUME_SCALE = 1.15f;
+
+	// Vec4 attributes per light instance, at attribute indices 3..6
+	const int INSTANCE_ATTRIBUTES = 4;
+	const GLuint FIRST_INSTANCE_ATTRIBUTE_INDEX = 3;
+
+} // namespace
+
+DeferredShading::~DeferredShading()
+{
+	deleteResources();
+}
+
+void DeferredShading::create(ProgramBinaryCache* binaryCache)
+{
+	deleteResources();
+
+	// light volume - positions of the generated sphere, vertices and indices share one buffer
+	auto sphere = ShapeGenerator::makeSphere(VOLUME_TESSELLATION);
+	glGenVertexArrays(1, &_volumeVAO);
+	glGenBuffers(1, &_volumeVBO);
+	glGenBuffers(1, &_instanceVBO);
+
+	glBindVertexArray(_volumeVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, _volumeVBO);
+	glBufferData(GL_ARRAY_BUFFER, sphere.vertexBufferSize() + sphere.indexBufferSize(), 0, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sphere.vertexBufferSize(), sphere.vertices);
+	glBufferSubData(GL_ARRAY_BUFFER, sphere.vertexBufferSize(), sphere.indexBufferSize(), sphere.indices);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _volumeVBO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+	for (auto i = 0; i < INSTANCE_ATTRIBUTES; i++)
+	{
+		const auto index = FIRST_INSTANCE_ATTRIBUTE_INDEX + i;
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, 4, GL_FLOAT, GL_FALSE, INSTANCE_ATTRIBUTES * sizeof(glm::vec4), (void*)(i * sizeof(glm::vec4)));
+		glVertexAttribDivisor(index, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GL_LABEL(GL_VERTEX_ARRAY, _volumeVAO, "Light volume");
+	GL_LABEL(GL_BUFFER, _instanceVBO, "Light volume instances");
+
+	// winding of the generated sphere is not guaranteed, its signed volume tells which faces look outwards
+	float signedVolume = 0.0f;
+	for (GLuint i = 0; i + 2 < sphere.numIndices; i += 3)
+	{
+		const auto& a = sphere.vertices[sphere.indices[i]].position;
+		const auto& b = sphere.vertices[sphere.indices[i + 1]].position;
+		const auto& c = sphere.vertices[sphere.indices[i + 2]].position;
+		signedVolume += glm::dot(a, glm::cross(b, c));
+	}
+	_volumeCullFace = signedVolume >= 0.0f ? GL_FRONT : GL_BACK;
+	_volumeDraw = DrawCommand::elements(GL_TRIANGLES, sphere.numIndices, GL_UNSIGNED_SHORT, sphere.vertexBufferSize());
+	sphere.cleanup();
+
+	_lightShader = std::make_unique<Shader>("res/shaders/deferred_light.vs", "res/shaders/deferred_light.fs", nullptr, std::string(), binaryCache);
+	setUp(*_lightShader);
+	if (_hotReload != nullptr) {
+		_hotReload->add(_lightShader.get(), setUp);
+	}
+}
+
+void DeferredShading::setHotReload(ShaderHotReload* hotReload)
+{
+	if (_lightShader)
+	{
+		if (_hotReload != nullptr) {
+			_hotReload->remove(_lightShader.get());
+		}
+		if (hotReload != nullptr) {
+			hotReload->add(_lightShader.get(), setUp);
+		}
+	}
+	_hotReload = hotReload;
+}
+
+void DeferredShading::setLights(const Scene& scene)
+{
+	std::vector<glm::vec4> instances;
+	instances.reserve(size_t(scene.getNumLights()) * INSTANCE_ATTRIBUTES);
+	for (uint32_t i = 0; i < scene.getNumLights(); i++)
+	{
+		const auto& light = scene.getLight(i);
+		instances.emplace_back(light.position, ClusteredLighting::computeInfluenceRadius(light));
+		instances.emplace_back(light.ambient, light.constant);
+		instances.emplace_back(light.diffuse, light.linear);
+		instances.emplace_back(light.specular, light.quadratic);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec4), instances.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	_numLights = GLsizei(scene.getNumLights());
+}
+
+bool DeferredShading::resize(int width, int height)
+{
+	if (_geometryFramebuffer != 0 && width == _width && height == _height) {
+		return true;
+	}
+	deleteTargets();
+
+	static const GLenum FORMATS[NUM_TARGETS] = { GL_RGBA8, GL_RGBA8, GL_RGB10_A2, GL_RGBA8 };
+	static const char* LABELS[NUM_TARGETS] = { "G-buffer albedo", "G-buffer specular", "G-buffer normal", "G-buffer accumulation" };
+	auto createTexture = [width, height](GLuint& texture, GLenum internalFormat, GLenum format, GLenum type, const char* label)
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		GL_LABEL(GL_TEXTURE, texture, label);
+	};
+	for (auto i = 0; i < NUM_TARGETS; i++) {
+		createTexture(_targets[i], FORMATS[i], GL_RGBA, GL_UNSIGNED_BYTE, LABELS[i]);
+	}
+	createTexture(_depth, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, "G-buffer depth");
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &_geometryFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _geometryFramebuffer);
+	for (auto i = 0; i < NUM_TARGETS; i++) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, _targets[i], 0);
+	}
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depth, 0);
+	GL_LABEL(GL_FRAMEBUFFER, _geometryFramebuffer, "G-buffer");
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	glGenFramebuffers(1, &_lightFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _lightFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _targets[ACCUMULATION_TARGET], 0);
+	GL_LABEL(GL_FRAMEBUFFER, _lightFramebuffer, "Light accumulation");
+	if (status == GL_FRAMEBUFFER_COMPLETE) {
+		status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "G-buffer " << width << "x" << height << " is not complete (status " << status << ")!" << std::endl;
+		deleteTargets();
+		_stats = DeferredShadingStats();
+		return false;
+	}
+
+	_width = width;
+	_height = height;
+	return true;
+}
+
+void DeferredShading::beginGeometryPass()
+{
+	_stats = DeferredShadingStats();
+	glBindFramebuffer(GL_FRAMEBUFFER, _geometryFramebuffer);
+	glViewport(0, 0, _width, _height);
+
+	// accumulation starts from the background, the rest from nothing
+	static const GLenum ALL_TARGETS[NUM_TARGETS] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+	static const GLfloat ZERO[4] = {};
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	glDrawBuffers(NUM_TARGETS, ALL_TARGETS);
+	glClearBufferfv(GL_COLOR, ALBEDO_TARGET, ZERO);
+	glClearBufferfv(GL_COLOR, SPECULAR_TARGET, ZERO);
+	glClearBufferfv(GL_COLOR, NORMAL_TARGET, ZERO);
+	glClearBufferfv(GL_COLOR, ACCUMULATION_TARGET, clearColor);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// the GBUFFER_PASS permutation writes fragment outputs 0..2
+	glDrawBuffers(ACCUMULATION_TARGET, ALL_TARGETS);
+}
+
+void DeferredShading::renderLights(const glm::mat4& view, const glm::mat4& projection)
+{
+	GL_DEBUG_GROUP("Deferred lights");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, _lightFramebuffer);
+	glViewport(0, 0, _width, _height);
+
+	const GLuint textures[] = { _targets[ALBEDO_TARGET], _targets[SPECULAR_TARGET], _targets[NORMAL_TARGET], _depth };
+	for (auto i = 0; i < 4; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + GBUFFER_ALBEDO_TEXTURE_UNIT + i);
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	// far faces of every volume add up the light they shade - the camera may be inside a volume, so depth test is off
+	// and the volume is clamped instead of clipped by the far plane
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_DEPTH_CLAMP);
+	glEnable(GL_CULL_FACE);
+	glCullFace(_volumeCullFace);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+
+	_lightShader->use();
+	_lightShader->setMat4("inverseViewProjection", glm::inverse(projection * view));
+	_lightShader->setVec2("inverseScreenSize", glm::vec2(1.0f / float(_width), 1.0f / float(_height)));
+	glBindVertexArray(_volumeVAO);
+	auto draw = _volumeDraw;
+	draw.numInstances = _numLights;
+	if (_numLights > 0)
+	{
+		draw.execute();
+		_stats.drawCalls++;
+		_stats.triangles += draw.getNumTriangles();
+	}
+	glBindVertexArray(0);
+
+	glDisable(GL_BLEND);
+	glCullFace(GL_BACK);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_DEPTH_CLAMP);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void DeferredShading::beginForwardPass()
+{
+	// fragment output 0 goes to the accumulation target
+	static const GLenum ACCUMULATION[] = { GL_COLOR_ATTACHMENT0 + ACCUMULATION_TARGET };
+	glBindFramebuffer(GL_FRAMEBUFFER, _geometryFramebuffer);
+	glDrawBuffers(1, ACCUMULATION);
+	glViewport(0, 0, _width, _height);
+}
+
+void DeferredShading::resolve(GLuint targetFramebuffer)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _lightFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+	glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+}
+
+const DeferredShadingStats& DeferredShading::getStats() const
+{
+	return _stats;
+}
+
+void DeferredShading::deleteResources()
+{
+	deleteTargets();
+	if (_volumeVAO != 0)
+	{
+		glDeleteVertexArrays(1, &_volumeVAO);
+		glDeleteBuffers(1, &_volumeVBO);
+		glDeleteBuffers(1, &_instanceVBO);
+		_volumeVAO = _volumeVBO = _instanceVBO = 0;
+	}
+	if (_lightShader)
+	{
+		if (_hotReload != nullptr) {
+			_hotReload->remove(_lightShader.get());
+		}
+		_lightShader->deleteProgram();
+		_lightShader.reset();
+	}
+	_numLights = 0;
+}
+
+void DeferredShading::setUp(Shader& program)
+{
+	program.use();
+	program.setInt("gAlbedo", GBUFFER_ALBEDO_TEXTURE_UNIT);
+	program.setInt("gSpecular", GBUFFER_SPECULAR_TEXTURE_UNIT);
+	program.setInt("gNormal", GBUFFER_NORMAL_TEXTURE_UNIT);
+	program.setInt("gDepth", GBUFFER_DEPTH_TEXTURE_UNIT);
+	program.setFloat("shininess", 32.0f);
+	program.setFloat("volumeScale", VOLUME_SCALE);
+	program.bindUniformBlock("FrameData", FRAME_BLOCK_BINDING);
+}
+
+void DeferredShading::deleteTargets()
+{
+	if (_geometryFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &_geometryFramebuffer);
+		glDeleteFramebuffers(1, &_lightFramebuffer);
+		glDeleteTextures(NUM_TARGETS, _targets);
+		glDeleteTextures(1, &_depth);
+		_geometryFramebuffer = _lightFramebuffer = _depth = 0;
+		for (auto& target : _targets) {
+			target = 0;
+		}
+	}
+	_width = _height = 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// STL
+#include <memory>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <glad/glad.h>
+
+// Project
+#include "DrawCommand.h"
+#include "Scene.h"
+#include "ShaderHotReload.h"
+#include "shader.h"
+
+/** Texture units the G-buffer is sampled from in the lighting pass (0 and 1 belong to materials, 2..4 to clustered lighting). */
+enum GBufferTextureUnit
+{
+	GBUFFER_ALBEDO_TEXTURE_UNIT = 5, //! "gAlbedo" - diffuse color of the material
+	GBUFFER_SPECULAR_TEXTURE_UNIT = 6, //! "gSpecular" - specular color of the material (black without specular map)
+	GBUFFER_NORMAL_TEXTURE_UNIT = 7, //! "gNormal" - world space normal, mapped to 0..1
+	GBUFFER_DEPTH_TEXTURE_UNIT = 8 //! "gDepth" - depth buffer, world position is reconstructed from it
+};
+
+/**
+  Statistics of the draws deferred shading adds to a frame (the objects go through the render queue).
+*/
+struct DeferredShadingStats
+{
+	int drawCalls = 0; //! Light volume draws of the last frame
+	uint64_t triangles = 0; //! Triangles of the light volumes of the last frame
+};
+
+/**
+  Deferred shading - lit objects write their material and normal into a G-buffer (GBUFFER_PASS permutation),
+  then every light draws its influence sphere and shades only the pixels under it, each of them once no matter
+  how much overdraw the scene had. Unlit objects are drawn forward on top, using the G-buffer depth,
+  and the result is blitted into the target framebuffer.
+*/
+class DeferredShading
+{
+public:
+	DeferredShading() = default;
+	~DeferredShading();
+
+	DeferredShading(const DeferredShading&) = delete;
+	DeferredShading& operator=(const DeferredShading&) = delete;
+
+	/** \brief Creates the light volume mesh and submits the lighting program (linked from binaries of given cache whenever possible). */
+	void create(ProgramBinaryCache* binaryCache = nullptr);
+
+	/** \brief Registers the lighting program for hot reload. */
+	void setHotReload(ShaderHotReload* hotReload);
+
+	/** \brief Uploads all lights of the scene as light volume instances (lights are static, so this is done once). */
+	void setLights(const Scene& scene);
+
+	/** \brief Creates the G-buffer with given resolution, if it does not have it already.
+	*   \return True if the G-buffer is complete, false otherwise.
+	*/
+	bool resize(int width, int height);
+
+	/** \brief Binds the G-buffer, clears it (accumulation buffer gets the current clear color) and sets viewport to cover it. */
+	void beginGeometryPass();
+
+	/** \brief Adds contributions of all lights into the accumulation buffer, reading the G-buffer filled by the geometry pass. */
+	void renderLights(const glm::mat4& view, const glm::mat4& projection);
+
+	/** \brief Binds the accumulation buffer with the G-buffer depth, for objects drawn without lighting. */
+	void beginForwardPass();
+
+	/** \brief Copies the accumulation buffer into given framebuffer and leaves it bound. */
+	void resolve(GLuint targetFramebuffer);
+
+	/** \brief Gets statistics of the draws of the last frame. */
+	const DeferredShadingStats& getStats() const;
+
+	/** \brief Deletes all textures, framebuffers, buffers and the program (the OpenGL context must still exist). */
+	void deleteResources();
+
+private:
+	enum RenderTarget
+	{
+		ALBEDO_TARGET = 0,
+		SPECULAR_TARGET = 1,
+		NORMAL_TARGET = 2,
+		ACCUMULATION_TARGET = 3,
+		NUM_TARGETS = 4
+	};
+
+	GLuint _geometryFramebuffer = 0; // All targets and depth, for the geometry and forward pass
+	GLuint _lightFramebuffer = 0; // Accumulation target only, so that the lighting pass can sample depth
+	GLuint _targets[NUM_TARGETS] = {}; // Color textures
+	GLuint _depth = 0; // Depth texture
+	int _width = 0;
+	int _height = 0;
+
+	GLuint _volumeVAO = 0; // Unit sphere with light instance attributes
+	GLuint _volumeVBO = 0; // Sphere vertices and indices
+	GLuint _instanceVBO = 0; // 4 vec4 per light: position + radius, ambient + constant, diffuse + linear, specular + quadratic
+	GLenum _volumeCullFace = GL_FRONT; // Faces turned to the camera, culled so that each pixel is shaded by the far side only
+	DrawCommand _volumeDraw;
+	GLsizei _numLights = 0;
+	DeferredShadingStats _stats;
+
+	std::unique_ptr<Shader> _lightShader; // deferred_light.vs/fs
+	ShaderHotReload* _hotReload = nullptr;
+
+	/** \brief Sets samplers and uniform blocks of the freshly linked lighting program. */
+	static void setUp(Shader& program);
+
+	/** \brief Deletes the G-buffer textures and framebuffers. */
+	void deleteTargets();
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+// STL
+#include <cstdint>
+
+#include <glad/glad.h>
+
+/**
+  Plain description of one draw call (what to draw, not with which state), so that draws
+  can be recorded, sorted and issued later, e.g. by a render queue.
+*/
+struct DrawCommand
+{
+	GLenum mode = GL_TRIANGLES; //! Primitive type
+	GLint first = 0; //! First vertex (non-indexed draws only)
+	GLsizei count = 0; //! Number of vertices (non-indexed) or indices (indexed) to draw
+	GLenum indexType = GL_NONE; //! Type of indices, GL_NONE for non-indexed draws
+	uintptr_t indexByteOffset = 0; //! Byte offset of the first index in the element buffer
+	GLsizei numInstances = 1; //! Number of instances, instanced draw is issued if more than 1
+	bool primitiveRestart = false; //! Flag telling, if primitive restart must be enabled for this draw
+	GLuint primitiveRestartIndex = 0; //! Index of primitive restart
+	GLsizei numPrimitiveRestarts = 0; //! Number of restart indices among the drawn ones (for triangle counting only)
+
+	/** \brief Creates non-indexed draw (glDrawArrays). */
+	static DrawCommand arrays(GLenum mode, GLint first, GLsizei count)
+	{
+		DrawCommand result;
+		result.mode = mode;
+		result.first = first;
+		result.count = count;
+		return result;
+	}
+
+	/** \brief Creates indexed draw (glDrawElements) from the element buffer of bound VAO. */
+	static DrawCommand elements(GLenum mode, GLsizei count, GLenum indexType, uintptr_t indexByteOffset = 0)
+	{
+		DrawCommand result;
+		result.mode = mode;
+		result.count = count;
+		result.indexType = indexType;
+		result.indexByteOffset = indexByteOffset;
+		return result;
+	}
+
+	/** \brief Checks, if this is an indexed draw. */
+	bool isIndexed() const
+	{
+		return indexType != GL_NONE;
+	}
+
+	/** \brief Gets number of triangles the draw produces (over all instances). */
+	uint64_t getNumTriangles() const
+	{
+		uint64_t trianglesPerInstance = 0;
+		switch (mode)
+		{
+		case GL_TRIANGLES:
+			trianglesPerInstance = count / 3;
+			break;
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+		{
+			// Every restart index is skipped and starts a new strip, which again needs two indices before first triangle
+			const auto numStripTriangles = int64_t(count) - 3 * int64_t(numPrimitiveRestarts) - 2;
+			trianglesPerInstance = numStripTriangles > 0 ? uint64_t(numStripTriangles) : 0;
+			break;
+		}
+		default:
+			break;
+		}
+		return trianglesPerInstance * uint64_t(numInstances);
+	}
+
+	/** \brief Issues the draw call. VAO (and primitive restart state) must be set by the caller. */
+	void execute() const
+	{
+		const auto indices = reinterpret_cast<const void*>(indexByteOffset);
+		if (isIndexed())
+		{
+			if (numInstances > 1) {
+				glDrawElementsInstanced(mode, count, indexType, indices, numInstances);
+			}
+			else {
+				glDrawElements(mode, count, indexType, indices);
+			}
+		}
+		else
+		{
+			if (numInstances > 1) {
+				glDrawArraysInstanced(mode, first, count, numInstances);
+			}
+			else {
+				glDrawArrays(mode, first, count);
+			}
+		}
+	}
+};
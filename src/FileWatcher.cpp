@@ -0,0 +1,131 @@
+// STL
+#include <algorithm>
+#include <iostream>
+
+// Project
+#include "FileWatcher.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifndef __linux__
+	const std::chrono::milliseconds SCAN_INTERVAL(250);
+#endif
+
+	std::string joinPath(const std::string& directory, const std::string& name)
+	{
+		return (std::filesystem::path(directory) / name).generic_string();
+	}
+
+} // namespace
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (_inotify != -1) {
+		close(_inotify);
+	}
+#endif
+}
+
+bool FileWatcher::watch(const std::string& directory)
+{
+#ifdef __linux__
+	if (_inotify == -1 && (_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1)
+	{
+		std::cerr << "Could not initialize inotify (" << strerror(errno) << ")!" << std::endl;
+		return false;
+	}
+
+	const auto descriptor = inotify_add_watch(_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (descriptor == -1)
+	{
+		std::cerr << "Could not watch directory " << directory << " (" << strerror(errno) << ")!" << std::endl;
+		return false;
+	}
+	_directories[descriptor] = directory;
+	return true;
+#else
+	std::error_code error;
+	if (!std::filesystem::is_directory(directory, error))
+	{
+		std::cerr << "Could not watch directory " << directory << "!" << std::endl;
+		return false;
+	}
+
+	// Files present now are the baseline, only later modifications are reported
+	std::vector<std::string> ignoredPaths;
+	scan(directory, ignoredPaths);
+	_directories.push_back(directory);
+	return true;
+#endif
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+	std::vector<std::string> changedPaths;
+#ifdef __linux__
+	if (_inotify == -1) {
+		return changedPaths;
+	}
+
+	// Read returns -1 with EAGAIN once there are no more events, the instance is non-blocking
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(_inotify, buffer, sizeof(buffer))) > 0)
+	{
+		for (ssize_t offset = 0; offset < length; )
+		{
+			const auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			const auto directory = _directories.find(event->wd);
+			if (event->len == 0 || directory == _directories.end()) {
+				continue;
+			}
+			const auto path = joinPath(directory->second, event->name);
+			if (std::find(changedPaths.begin(), changedPaths.end(), path) == changedPaths.end()) {
+				changedPaths.push_back(path);
+			}
+		}
+	}
+#else
+	const auto now = std::chrono::steady_clock::now();
+	if (now - _lastScan < SCAN_INTERVAL) {
+		return changedPaths;
+	}
+	_lastScan = now;
+	for (const auto& directory : _directories) {
+		scan(directory, changedPaths);
+	}
+#endif
+	return changedPaths;
+}
+
+#ifndef __linux__
+void FileWatcher::scan(const std::string& directory, std::vector<std::string>& changedPaths)
+{
+	std::error_code error;
+	for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+	{
+		if (!it->is_regular_file(error)) {
+			continue;
+		}
+
+		const auto path = joinPath(directory, it->path().filename().string());
+		const auto writeTime = it->last_write_time(error);
+		auto& lastWriteTime = _writeTimes[path];
+		if (writeTime != lastWriteTime)
+		{
+			lastWriteTime = writeTime;
+			changedPaths.push_back(path);
+		}
+	}
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+// STL
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+  Reports files changed in watched directories without ever blocking. On Linux it reads inotify events
+  (files written and closed, or moved in - editors often save through a temporary file), elsewhere it
+  compares modification times of the directory entries a few times a second.
+*/
+class FileWatcher
+{
+public:
+	FileWatcher() = default;
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+	~FileWatcher();
+
+	/** \brief Starts watching files of given directory (not its subdirectories).
+	*   \return True if the directory is watched, false otherwise.
+	*/
+	bool watch(const std::string& directory);
+
+	/** \brief Gets paths (directory/name, as given to watch) of files changed since the last call, each once. */
+	std::vector<std::string> poll();
+
+private:
+#ifdef __linux__
+	int _inotify = -1; // Non-blocking inotify instance
+	std::unordered_map<int, std::string> _directories; // Watched directories by watch descriptor
+#else
+	std::vector<std::string> _directories; // Watched directories
+	std::unordered_map<std::string, std::filesystem::file_time_type> _writeTimes; // Last seen modification time by path
+	std::chrono::steady_clock::time_point _lastScan; // Directories are scanned a few times a second only
+
+	/** \brief Scans the directory, returns files, that are new or have been modified since the last scan. */
+	void scan(const std::string& directory, std::vector<std::string>& changedPaths);
+#endif
+};
@@ -0,0 +1,123 @@
+// STL
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Project
+#include "Framebuffer.h"
+#include "GLDebug.h"
+
+Framebuffer::~Framebuffer()
+{
+	deleteFramebuffer();
+}
+
+bool Framebuffer::create(int width, int height)
+{
+	deleteFramebuffer();
+
+	glGenRenderbuffers(1, &_colorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, _colorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &_depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, _depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthRenderbuffer);
+	GL_LABEL(GL_FRAMEBUFFER, _framebuffer, "Offscreen framebuffer");
+
+	const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Framebuffer " << width << "x" << height << " is not complete (status " << status << ")!" << std::endl;
+		deleteFramebuffer();
+		return false;
+	}
+
+	_width = width;
+	_height = height;
+	return true;
+}
+
+void Framebuffer::bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glViewport(0, 0, _width, _height);
+}
+
+void Framebuffer::readPixels(std::vector<unsigned char>& pixels) const
+{
+	const size_t rowSize = size_t(_width) * 4;
+	pixels.resize(rowSize * _height);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	// OpenGL rows go from bottom to top
+	std::vector<unsigned char> row(rowSize);
+	for (int y = 0; y < _height / 2; y++)
+	{
+		auto top = pixels.data() + y * rowSize;
+		auto bottom = pixels.data() + (_height - 1 - y) * rowSize;
+		memcpy(row.data(), top, rowSize);
+		memcpy(top, bottom, rowSize);
+		memcpy(bottom, row.data(), rowSize);
+	}
+}
+
+bool Framebuffer::writePPM(const std::string& path) const
+{
+	std::vector<unsigned char> pixels;
+	readPixels(pixels);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Could not open image file " << path << " for writing!" << std::endl;
+		return false;
+	}
+
+	file << "P6\n" << _width << " " << _height << "\n255\n";
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+	}
+
+	return file.good();
+}
+
+void Framebuffer::deleteFramebuffer()
+{
+	if (_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &_framebuffer);
+		_framebuffer = 0;
+	}
+	if (_colorRenderbuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &_colorRenderbuffer);
+		_colorRenderbuffer = 0;
+	}
+	if (_depthRenderbuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &_depthRenderbuffer);
+		_depthRenderbuffer = 0;
+	}
+	_width = _height = 0;
+}
+
+int Framebuffer::getWidth() const
+{
+	return _width;
+}
+
+int Framebuffer::getHeight() const
+{
+	return _height;
+}
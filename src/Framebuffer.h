@@ -0,0 +1,50 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+/**
+  Offscreen render target - RGBA8 color and 24-bit depth renderbuffers attached to one framebuffer object.
+  Used instead of the default framebuffer when rendering without a window.
+*/
+class Framebuffer
+{
+public:
+	Framebuffer() = default;
+	~Framebuffer();
+
+	Framebuffer(const Framebuffer&) = delete;
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	/** \brief Creates the framebuffer with given resolution (deletes previous one first).
+	*   \return True if the framebuffer is complete, false otherwise.
+	*/
+	bool create(int width, int height);
+
+	/** \brief Binds the framebuffer for drawing and sets viewport to cover it. */
+	void bind() const;
+
+	/** \brief Reads color buffer back to CPU, as tightly packed RGBA rows from top to bottom. */
+	void readPixels(std::vector<unsigned char>& pixels) const;
+
+	/** \brief Writes color buffer into a binary PPM image.
+	*   \return True if the image has been written, false otherwise.
+	*/
+	bool writePPM(const std::string& path) const;
+
+	/** \brief Deletes the framebuffer and its renderbuffers. */
+	void deleteFramebuffer();
+
+	int getWidth() const;
+	int getHeight() const;
+
+private:
+	GLuint _framebuffer = 0; //! Framebuffer object ID
+	GLuint _colorRenderbuffer = 0; //! RGBA8 color attachment
+	GLuint _depthRenderbuffer = 0; //! Depth attachment
+	int _width = 0; //! Width in pixels
+	int _height = 0; //! Height in pixels
+};
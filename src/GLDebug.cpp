@@ -0,0 +1,145 @@
+// Project
+#include "GLDebug.h"
+
+#if GLDEBUG_ENABLED
+
+// STL
+#include <csignal>
+#include <iostream>
+
+// Project
+#include "GLExtensions.h"
+
+namespace {
+
+	/** Stops in the debugger, the way the old per-call ASSERT did. */
+	void debugBreak()
+	{
+#if defined(_MSC_VER)
+		__debugbreak();
+#elif defined(SIGTRAP)
+		raise(SIGTRAP);
+#endif
+	}
+
+	const char* sourceName(GLenum source)
+	{
+		switch (source)
+		{
+		case GL_DEBUG_SOURCE_API: return "API";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "Window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "Third party";
+		case GL_DEBUG_SOURCE_APPLICATION: return "Application";
+		default: return "Other";
+		}
+	}
+
+	const char* typeName(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_DEBUG_TYPE_ERROR: return "Error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated behavior";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "Undefined behavior";
+		case GL_DEBUG_TYPE_PORTABILITY: return "Portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "Performance";
+		case GL_DEBUG_TYPE_MARKER: return "Marker";
+		default: return "Other";
+		}
+	}
+
+	const char* severityName(GLenum severity)
+	{
+		switch (severity)
+		{
+		case GL_DEBUG_SEVERITY_HIGH: return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+		case GL_DEBUG_SEVERITY_LOW: return "low";
+		default: return "notification";
+		}
+	}
+
+	void APIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+		GLsizei /*length*/, const GLchar* message, const void* /*userParam*/)
+	{
+		std::cout << "[OpenGL " << typeName(type) << "] (" << sourceName(source) << ", " << severityName(severity)
+			<< ", " << id << ") " << message << std::endl;
+
+		// Output is synchronous, so the offending call is right on the stack
+		if (type == GL_DEBUG_TYPE_ERROR) {
+			debugBreak();
+		}
+	}
+
+} // namespace
+
+bool GLDebug::_isAvailable = false;
+
+bool GLDebug::initialize(GLADloadproc load)
+{
+	// Functions are core since 4.3, glad loads no extensions, so with GL_KHR_debug on older context we load them ourselves
+	_isAvailable = GLAD_GL_VERSION_4_3 != 0;
+	if (!_isAvailable && hasGLExtension("GL_KHR_debug"))
+	{
+		glad_glDebugMessageCallback = reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(load("glDebugMessageCallback"));
+		glad_glDebugMessageControl = reinterpret_cast<PFNGLDEBUGMESSAGECONTROLPROC>(load("glDebugMessageControl"));
+		glad_glObjectLabel = reinterpret_cast<PFNGLOBJECTLABELPROC>(load("glObjectLabel"));
+		glad_glPushDebugGroup = reinterpret_cast<PFNGLPUSHDEBUGGROUPPROC>(load("glPushDebugGroup"));
+		glad_glPopDebugGroup = reinterpret_cast<PFNGLPOPDEBUGGROUPPROC>(load("glPopDebugGroup"));
+		_isAvailable = glad_glDebugMessageCallback != nullptr && glad_glDebugMessageControl != nullptr
+			&& glad_glObjectLabel != nullptr && glad_glPushDebugGroup != nullptr && glad_glPopDebugGroup != nullptr;
+	}
+
+	if (!_isAvailable)
+	{
+		std::cout << "GL_KHR_debug is not available, OpenGL errors are checked once per frame only" << std::endl;
+		return false;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(debugMessageCallback, nullptr);
+
+	// Notifications (buffer placement and such) and our own group markers would only flood the output
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	return true;
+}
+
+void GLDebug::checkErrors(const char* where)
+{
+	if (_isAvailable) {
+		return;
+	}
+
+	while (GLenum error = glGetError())
+	{
+		std::cout << "[OpenGL Error] (" << error << ") " << where << std::endl;
+		debugBreak();
+	}
+}
+
+void GLDebug::label(GLenum identifier, GLuint name, const char* label)
+{
+	if (_isAvailable) {
+		glObjectLabel(identifier, name, -1, label);
+	}
+}
+
+void GLDebug::pushGroup(const char* name)
+{
+	if (_isAvailable) {
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	}
+}
+
+void GLDebug::popGroup()
+{
+	if (_isAvailable) {
+		glPopDebugGroup();
+	}
+}
+
+#endif
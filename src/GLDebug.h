@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/*
+  OpenGL error reporting through GL_KHR_debug - the driver calls us back with a message for every error
+  (and warning), so no call has to be followed by glGetError. Objects can be labelled and draws grouped,
+  so that the messages and frame captures (RenderDoc, apitrace) tell what they are about.
+
+  It's on in debug builds only, in release builds all the macros below compile to nothing.
+  Define GLDEBUG_ENABLED to 0 or 1 to override that.
+*/
+#ifndef GLDEBUG_ENABLED
+#ifdef NDEBUG
+#define GLDEBUG_ENABLED 0
+#else
+#define GLDEBUG_ENABLED 1
+#endif
+#endif
+
+#if GLDEBUG_ENABLED
+
+class GLDebug
+{
+public:
+	/** \brief Installs the debug message callback, call right after glad has been loaded.
+	*   \param load Loader given to glad, used to get GL_KHR_debug entry points on contexts older than 4.3
+	*   \return True if debug output is available, false if only the per-frame glGetError fallback works.
+	*/
+	static bool initialize(GLADloadproc load);
+
+	/** \brief Reports errors through glGetError, only if debug output is not available. */
+	static void checkErrors(const char* where);
+
+	/** \brief Gives an object a human readable name (shown in debug messages and frame captures). */
+	static void label(GLenum identifier, GLuint name, const char* label);
+
+	/** \brief Opens named group of commands, must be closed by popGroup. */
+	static void pushGroup(const char* name);
+
+	/** \brief Closes group opened by pushGroup. */
+	static void popGroup();
+
+private:
+	static bool _isAvailable; //! Flag telling, if GL_KHR_debug functions can be used
+};
+
+/**
+  Debug group open for the lifetime of the object.
+*/
+class GLDebugGroup
+{
+public:
+	explicit GLDebugGroup(const char* name) { GLDebug::pushGroup(name); }
+	~GLDebugGroup() { GLDebug::popGroup(); }
+
+	GLDebugGroup(const GLDebugGroup&) = delete;
+	GLDebugGroup& operator=(const GLDebugGroup&) = delete;
+};
+
+#define GLDEBUG_CONCAT_IMPL(a, b) a##b
+#define GLDEBUG_CONCAT(a, b) GLDEBUG_CONCAT_IMPL(a, b)
+
+#define GL_DEBUG_INITIALIZE(load) GLDebug::initialize(load)
+#define GL_CHECK_ERRORS(where) GLDebug::checkErrors(where)
+#define GL_LABEL(identifier, name, text) GLDebug::label(identifier, name, text)
+#define GL_DEBUG_GROUP(name) GLDebugGroup GLDEBUG_CONCAT(debugGroup, __LINE__)(name)
+
+#else
+
+#define GL_DEBUG_INITIALIZE(load) ((void)0)
+#define GL_CHECK_ERRORS(where) ((void)0)
+#define GL_LABEL(identifier, name, text) ((void)0)
+#define GL_DEBUG_GROUP(name) ((void)0)
+
+#endif
@@ -0,0 +1,19 @@
+// STL
+#include <cstring>
+
+// Project
+#include "GLExtensions.h"
+
+bool hasGLExtension(const char* name)
+{
+	GLint numExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+	for (GLint i = 0; i < numExtensions; i++)
+	{
+		const auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (extension != nullptr && strcmp(extension, name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/** \brief Checks, if the current context exposes given extension (e.g. "GL_ARB_texture_storage").
+*   glad is generated for the core profile without extensions, so they are looked up here, call after glad has been loaded.
+*/
+bool hasGLExtension(const char* name);
@@ -0,0 +1,182 @@
+// STL
+#include <iostream>
+
+// Project
+#include "HeadlessContext.h"
+
+#ifdef HEADLESS_OSMESA
+
+#include <GL/osmesa.h>
+
+HeadlessContext::~HeadlessContext()
+{
+	destroy();
+}
+
+bool HeadlessContext::create(int width, int height, bool /*debugContext*/)
+{
+	destroy();
+
+	const int attributes[] = {
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 24,
+		OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 3,
+		OSMESA_CONTEXT_MINOR_VERSION, 3,
+		0
+	};
+	_context = OSMesaCreateContextAttribs(attributes, nullptr);
+	if (_context == nullptr)
+	{
+		std::cerr << "Failed to create OSMesa OpenGL 3.3 core context!" << std::endl;
+		return false;
+	}
+
+	_buffer = new unsigned char[size_t(width) * size_t(height) * 4];
+	if (!OSMesaMakeCurrent(static_cast<OSMesaContext>(_context), _buffer, GL_UNSIGNED_BYTE, width, height))
+	{
+		std::cerr << "Failed to make OSMesa context current!" << std::endl;
+		destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void HeadlessContext::destroy()
+{
+	if (_context != nullptr)
+	{
+		OSMesaDestroyContext(static_cast<OSMesaContext>(_context));
+		_context = nullptr;
+	}
+	delete[] _buffer;
+	_buffer = nullptr;
+}
+
+void* HeadlessContext::getProcAddress(const char* name)
+{
+	return reinterpret_cast<void*>(OSMesaGetProcAddress(name));
+}
+
+#elif defined(__linux__)
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+HeadlessContext::~HeadlessContext()
+{
+	destroy();
+}
+
+bool HeadlessContext::create(int /*width*/, int /*height*/, bool debugContext)
+{
+	destroy();
+
+	// Surfaceless platform needs no GPU device nor display server, fall back to the default display without it
+	EGLDisplay display = EGL_NO_DISPLAY;
+	const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (getPlatformDisplay != nullptr) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cerr << "Failed to initialize EGL display!" << std::endl;
+		return false;
+	}
+	_display = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cerr << "EGL does not support desktop OpenGL!" << std::endl;
+		destroy();
+		return false;
+	}
+
+	// We never create a surface, so any OpenGL capable config will do
+	const EGLint configAttributes[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0) {
+		config = nullptr; // EGL_KHR_no_config_context
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_CONTEXT_OPENGL_DEBUG, debugContext ? EGL_TRUE : EGL_FALSE,
+		EGL_NONE
+	};
+	const auto context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cerr << "Failed to create EGL OpenGL 3.3 core context!" << std::endl;
+		destroy();
+		return false;
+	}
+	_context = context;
+
+	// EGL_KHR_surfaceless_context - the context is current without any default framebuffer
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cerr << "Failed to make EGL context current without surface!" << std::endl;
+		destroy();
+		return false;
+	}
+
+	std::cout << "Headless EGL " << major << "." << minor << " context created" << std::endl;
+	return true;
+}
+
+void HeadlessContext::destroy()
+{
+	if (_display == nullptr) {
+		return;
+	}
+
+	eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (_context != nullptr)
+	{
+		eglDestroyContext(_display, _context);
+		_context = nullptr;
+	}
+	eglTerminate(_display);
+	_display = nullptr;
+}
+
+void* HeadlessContext::getProcAddress(const char* name)
+{
+	return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+#else
+
+HeadlessContext::~HeadlessContext()
+{
+}
+
+bool HeadlessContext::create(int /*width*/, int /*height*/, bool /*debugContext*/)
+{
+	std::cerr << "Headless rendering is not supported on this platform (build with HEADLESS_OSMESA)!" << std::endl;
+	return false;
+}
+
+void HeadlessContext::destroy()
+{
+}
+
+void* HeadlessContext::getProcAddress(const char* /*name*/)
+{
+	return nullptr;
+}
+
+#endif
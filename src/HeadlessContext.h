@@ -0,0 +1,40 @@
+#pragma once
+
+/**
+  OpenGL 3.3 core context without any window or display, for machines with no GPU and no display server
+  (e.g. Mesa llvmpipe on build agents). Nothing is presented, so the rendering goes into a Framebuffer.
+
+  EGL with the surfaceless platform is used by default, define HEADLESS_OSMESA to use OSMesa instead.
+*/
+class HeadlessContext
+{
+public:
+	HeadlessContext() = default;
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	/** \brief Creates the context and makes it current on calling thread.
+	*   \param width Width of the offscreen image (OSMesa needs a buffer to bind the context to)
+	*   \param height Height of the offscreen image
+	*   \param debugContext True to request debug context (for GL_KHR_debug output)
+	*   \return True if the context has been created, false otherwise.
+	*/
+	bool create(int width, int height, bool debugContext = false);
+
+	/** \brief Destroys the context (all OpenGL objects have to be deleted before). */
+	void destroy();
+
+	/** \brief Gets OpenGL function address, to be passed to gladLoadGLLoader. */
+	static void* getProcAddress(const char* name);
+
+private:
+#ifdef HEADLESS_OSMESA
+	void* _context = nullptr; //! OSMesaContext
+	unsigned char* _buffer = nullptr; //! Color buffer OSMesa binds the context to
+#else
+	void* _display = nullptr; //! EGLDisplay
+	void* _context = nullptr; //! EGLContext
+#endif
+};
@@ -0,0 +1,224 @@
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// Project
+#include "IndexedCylinder.h"
+
+namespace static_meshes_3D {
+
+	IndexedCylinder::IndexedCylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals)
+		: StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals)
+		, _radius(radius)
+		, _numSlices(numSlices)
+		, _height(height)
+	{
+		initializeData();
+	}
+
+	float IndexedCylinder::getRadius() const
+	{
+		return _radius;
+	}
+
+	int IndexedCylinder::getSlices() const
+	{
+		return _numSlices;
+	}
+
+	float IndexedCylinder::getHeight() const
+	{
+		return _height;
+	}
+
+	size_t IndexedCylinder::getGPUByteSize() const
+	{
+		if (!_isInitialized) {
+			return 0;
+		}
+
+		return size_t(getVertexByteSize()) * _numVertices + sizeof(GLuint) * _numIndices;
+	}
+
+	void IndexedCylinder::initializeData()
+	{
+		if (_isInitialized) {
+			return;
+		}
+
+		// Side needs the first slice twice (texture wraps around), covers share their ring vertices
+		// among all triangles, so they don't need center vertex nor the repeated slice
+		const auto numVerticesSide = (_numSlices + 1) * 2;
+		const auto numVerticesCover = _numSlices;
+		_numVertices = numVerticesSide + numVerticesCover * 2;
+		_primitiveRestartIndex = _numVertices;
+
+		// Generate VAO and VBO for vertex attributes
+		glGenVertexArrays(1, &_vao);
+		glBindVertexArray(_vao);
+		_vbo.createVBO(getVertexByteSize() * _numVertices);
+
+		// Pre-calculate sines / cosines for given number of slices
+		const auto sliceAngleStep = 2.0f * glm::pi<float>() / float(_numSlices);
+		auto currentSliceAngle = 0.0f;
+		std::vector<float> sines, cosines;
+		for (auto i = 0; i <= _numSlices; i++)
+		{
+			sines.push_back(sin(currentSliceAngle));
+			cosines.push_back(cos(currentSliceAngle));
+
+			// Update slice angle
+			currentSliceAngle += sliceAngleStep;
+		}
+
+		if (hasPositions())
+		{
+			// Add cylinder side vertices
+			for (auto i = 0; i <= _numSlices; i++)
+			{
+				_vbo.addData(glm::vec3(cosines[i] * _radius, _height / 2.0f, sines[i] * _radius));
+				_vbo.addData(glm::vec3(cosines[i] * _radius, -_height / 2.0f, sines[i] * _radius));
+			}
+
+			// Add top cylinder cover ring
+			for (auto i = 0; i < _numSlices; i++) {
+				_vbo.addData(glm::vec3(cosines[i] * _radius, _height / 2.0f, sines[i] * _radius));
+			}
+
+			// Add bottom cylinder cover ring (mirrored, so that it faces down)
+			for (auto i = 0; i < _numSlices; i++) {
+				_vbo.addData(glm::vec3(cosines[i] * _radius, -_height / 2.0f, -sines[i] * _radius));
+			}
+		}
+
+		if (hasTextureCoordinates())
+		{
+			// Map the texture twice around cylinder, same as the non-indexed cylinder
+			const auto sliceTextureStepU = 2.0f / float(_numSlices);
+
+			auto currentSliceTexCoordU = 0.0f;
+			for (auto i = 0; i <= _numSlices; i++)
+			{
+				_vbo.addData(glm::vec2(currentSliceTexCoordU, 1.0f));
+				_vbo.addData(glm::vec2(currentSliceTexCoordU, 0.0f));
+
+				// Update texture coordinate of current slice
+				currentSliceTexCoordU += sliceTextureStepU;
+			}
+
+			// Generate circle texture coordinates for cylinder top cover
+			const glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
+			for (auto i = 0; i < _numSlices; i++) {
+				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f));
+			}
+
+			// Generate circle texture coordinates for cylinder bottom cover
+			for (auto i = 0; i < _numSlices; i++) {
+				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f));
+			}
+		}
+
+		if (hasNormals())
+		{
+			for (auto i = 0; i <= _numSlices; i++) {
+				_vbo.addData(glm::vec3(cosines[i], 0.0f, sines[i]), 2);
+			}
+
+			// Add normal for every vertex of cylinder top cover
+			_vbo.addData(glm::vec3(0.0f, 1.0f, 0.0f), numVerticesCover);
+
+			// Add normal for every vertex of cylinder bottom cover
+			_vbo.addData(glm::vec3(0.0f, -1.0f, 0.0f), numVerticesCover);
+		}
+
+		// Finally upload vertex data to the GPU
+		_vbo.bindVBO();
+		_vbo.uploadDataToGPU(GL_STATIC_DRAW);
+		setVertexAttributesPointers(_numVertices);
+
+		// Side is one strip of top / bottom vertex pairs
+		_indicesVBO.createVBO(sizeof(GLuint) * (_numVertices + 2));
+		_indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
+		for (auto i = 0; i < numVerticesSide; i++) {
+			_indicesVBO.addData(GLuint(i));
+		}
+
+		// Covers are convex polygons, so they are triangulated by strips zig-zagging between
+		// both ends of the ring (0, 1, n-1, 2, n-2, ...), which keeps the winding of triangle fan
+		for (auto cover = 0; cover < 2; cover++)
+		{
+			const auto ringStart = GLuint(numVerticesSide + cover * numVerticesCover);
+			_indicesVBO.addData(GLuint(_primitiveRestartIndex));
+			_indicesVBO.addData(ringStart);
+
+			auto low = 1;
+			auto high = _numSlices - 1;
+			while (low <= high)
+			{
+				_indicesVBO.addData(ringStart + low++);
+				if (low <= high) {
+					_indicesVBO.addData(ringStart + high--);
+				}
+			}
+		}
+
+		_numIndices = numVerticesSide + (_numSlices + 1) * 2;
+		_indicesVBO.uploadDataToGPU(GL_STATIC_DRAW);
+
+		_isInitialized = true;
+	}
+
+	DrawCommand IndexedCylinder::getDrawCommand() const
+	{
+		auto result = DrawCommand::elements(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT);
+		result.primitiveRestart = true;
+		result.primitiveRestartIndex = _primitiveRestartIndex;
+		result.numPrimitiveRestarts = 2; // One before each cap
+		return result;
+	}
+
+	void IndexedCylinder::render() const
+	{
+		if (!_isInitialized) {
+			return;
+		}
+
+		glBindVertexArray(_vao);
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(_primitiveRestartIndex);
+
+		glDrawElements(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0);
+
+		glDisable(GL_PRIMITIVE_RESTART);
+	}
+
+	void IndexedCylinder::renderInstanced(int numInstances) const
+	{
+		if (!_isInitialized) {
+			return;
+		}
+
+		glBindVertexArray(_vao);
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(_primitiveRestartIndex);
+
+		glDrawElementsInstanced(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0, numInstances);
+
+		glDisable(GL_PRIMITIVE_RESTART);
+	}
+
+	void IndexedCylinder::renderPoints() const
+	{
+		if (!_isInitialized) {
+			return;
+		}
+
+		// Just render all points as they are stored in the VBO
+		glBindVertexArray(_vao);
+		glDrawArrays(GL_POINTS, 0, _numVertices);
+	}
+
+} // namespace static_meshes_3D
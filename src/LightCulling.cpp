@@ -0,0 +1,108 @@
+// STL
+#include <algorithm>
+#include <chrono>
+
+// Project
+#include "ClusteredLighting.h"
+#include "LightCulling.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_CULLING_SSE 1
+#include <emmintrin.h>
+#else
+#define LIGHT_CULLING_SSE 0
+#endif
+
+namespace {
+
+	// Lights tested at once, spheres are padded to a multiple of it
+	const size_t SIMD_WIDTH = 4;
+
+} // namespace
+
+void LightCulling::setLights(const Scene& scene)
+{
+	const auto numLights = std::min(scene.getNumLights(), MAX_POINT_LIGHTS);
+	const size_t numPadded = (size_t(numLights) + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	_centerX.assign(numPadded, 0.0f);
+	_centerY.assign(numPadded, 0.0f);
+	_centerZ.assign(numPadded, 0.0f);
+	// squared distance is never negative, so padding never passes the test
+	_radiusSquared.assign(numPadded, -1.0f);
+	for (uint32_t i = 0; i < numLights; i++)
+	{
+		const auto& light = scene.getLight(i);
+		const auto radius = ClusteredLighting::computeInfluenceRadius(light);
+		_centerX[i] = light.position.x;
+		_centerY[i] = light.position.y;
+		_centerZ[i] = light.position.z;
+		_radiusSquared[i] = radius > 0.0f ? radius * radius : -1.0f;
+	}
+	_stats = LightCullingStats();
+	_stats.numLights = numLights;
+}
+
+int LightCulling::findLights(const glm::vec3& boxMin, const glm::vec3& boxMax, int lights[MAX_LIGHTS_PER_OBJECT])
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	// Squared distance from sphere center to the closest point of the box, the sphere touches the box if it's within radius,
+	// there are never more spheres than fit into the list
+	size_t numLights = 0;
+#if LIGHT_CULLING_SSE
+	const auto zero = _mm_setzero_ps();
+	const auto minX = _mm_set1_ps(boxMin.x), minY = _mm_set1_ps(boxMin.y), minZ = _mm_set1_ps(boxMin.z);
+	const auto maxX = _mm_set1_ps(boxMax.x), maxY = _mm_set1_ps(boxMax.y), maxZ = _mm_set1_ps(boxMax.z);
+	for (size_t i = 0; i < _radiusSquared.size(); i += SIMD_WIDTH)
+	{
+		const auto centerX = _mm_loadu_ps(&_centerX[i]);
+		const auto centerY = _mm_loadu_ps(&_centerY[i]);
+		const auto centerZ = _mm_loadu_ps(&_centerZ[i]);
+		const auto dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, centerX), _mm_sub_ps(centerX, maxX)), zero);
+		const auto dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, centerY), _mm_sub_ps(centerY, maxY)), zero);
+		const auto dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, centerZ), _mm_sub_ps(centerZ, maxZ)), zero);
+		const auto distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		const auto radiusSquared = _mm_loadu_ps(&_radiusSquared[i]);
+		const auto mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, radiusSquared));
+		if (mask == 0) {
+			continue;
+		}
+		for (size_t lane = 0; lane < SIMD_WIDTH; lane++)
+		{
+			if ((mask & (1 << lane)) != 0) {
+				lights[numLights++] = int(i + lane);
+			}
+		}
+	}
+#else
+	for (size_t i = 0; i < _radiusSquared.size(); i++)
+	{
+		const auto dx = std::max(std::max(boxMin.x - _centerX[i], _centerX[i] - boxMax.x), 0.0f);
+		const auto dy = std::max(std::max(boxMin.y - _centerY[i], _centerY[i] - boxMax.y), 0.0f);
+		const auto dz = std::max(std::max(boxMin.z - _centerZ[i], _centerZ[i] - boxMax.z), 0.0f);
+		const auto distanceSquared = dx * dx + dy * dy + dz * dz;
+		if (distanceSquared <= _radiusSquared[i]) {
+			lights[numLights++] = int(i);
+		}
+	}
+#endif
+
+	_stats.numLists++;
+	_stats.numTests += _radiusSquared.size();
+	_stats.numListedLights += numLights;
+	const std::chrono::duration<double, std::milli> buildTime = std::chrono::steady_clock::now() - start;
+	_stats.buildTimeMs += buildTime.count();
+	return int(numLights);
+}
+
+const LightCullingStats& LightCulling::getStats() const
+{
+	return _stats;
+}
+
+void LightCulling::printStats(std::ostream& os) const
+{
+	os << "Light culling: " << _stats.numLights << " lights, " << _stats.numLists << " lists, " << _stats.numTests << " tests ("
+		<< (LIGHT_CULLING_SSE ? "SSE" : "scalar") << "), " << _stats.numListedLights << " listed lights ("
+		<< (_stats.numLists > 0 ? double(_stats.numListedLights) / _stats.numLists : 0.0) << " per list on average), built in " << _stats.buildTimeMs << " ms" << std::endl;
+}
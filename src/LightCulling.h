@@ -0,0 +1,59 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "Scene.h"
+#include "UniformBlocks.h"
+
+/**
+  Statistics of all light lists built since the lights were set.
+*/
+struct LightCullingStats
+{
+	uint32_t numLights = 0; //! Lights of the scene
+	uint32_t numLists = 0; //! Light lists built (objects and instanced batches)
+	uint64_t numTests = 0; //! Sphere-box tests done, padding of the last SIMD group included
+	uint64_t numListedLights = 0; //! Lights over all lists
+	double buildTimeMs = 0.0; //! CPU time of building all lists
+};
+
+/**
+  Forward light culling on the CPU - every light gets an influence sphere (its radius is where the attenuated light
+  drops below 1/256), and every lit object gets the list of lights whose sphere touches its world space bounding box,
+  so that its fragments evaluate only those (LIGHT_CULLING permutation). Only lights that cannot reach the box are skipped,
+  the lists hold all lights of the LightData block (MAX_LIGHTS_PER_OBJECT is MAX_POINT_LIGHTS). Lights are tested four at a time with SSE,
+  scenes and lights are static, so the lists are built once when the scene resources are.
+*/
+class LightCulling
+{
+public:
+	/** \brief Takes influence spheres of the lights of the scene the LightData block holds (the first MAX_POINT_LIGHTS), list indices refer to scene lights. */
+	void setLights(const Scene& scene);
+
+	/** \brief Finds all lights touching given world space box, in the order of the scene.
+	*   \param lights Receives the light indices, MAX_LIGHTS_PER_OBJECT at most
+	*   \return Number of lights written into the list.
+	*/
+	int findLights(const glm::vec3& boxMin, const glm::vec3& boxMax, int lights[MAX_LIGHTS_PER_OBJECT]);
+
+	/** \brief Gets statistics of the lists built so far. */
+	const LightCullingStats& getStats() const;
+
+	/** \brief Prints statistics of the lists built so far in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+private:
+	// Influence spheres as structure of arrays, padded to a multiple of 4 with spheres that touch nothing
+	std::vector<float> _centerX;
+	std::vector<float> _centerY;
+	std::vector<float> _centerZ;
+	std::vector<float> _radiusSquared;
+	LightCullingStats _stats;
+};
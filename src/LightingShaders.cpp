@@ -0,0 +1,197 @@
+// STL
+#include <algorithm>
+#include <thread>
+
+// Project
+#include "ClusteredLighting.h"
+#include "LightingShaders.h"
+#include "ShadowMaps.h"
+#include "UniformBlocks.h"
+
+namespace {
+
+	// Layout of the permutation key: light count in the lowest byte, then one bit per feature
+	const uint32_t NUM_POINT_LIGHTS_MASK = 0xFF;
+	const uint32_t DIR_LIGHT_BIT = 1u << 8;
+	const uint32_t SPECULAR_MAP_BIT = 1u << 9;
+	const uint32_t INSTANCED_BIT = 1u << 10;
+	const uint32_t LEGACY_NORMAL_MATRIX_BIT = 1u << 11;
+	const uint32_t CLUSTERED_BIT = 1u << 12;
+	const uint32_t GBUFFER_BIT = 1u << 13;
+	const uint32_t LIGHT_CULLING_BIT = 1u << 14;
+	const uint32_t SHADOWS_BIT = 1u << 15;
+	const uint32_t TEXTURE_ARRAYS_BIT = 1u << 16;
+
+} // namespace
+
+uint32_t LightingPermutation::getKey() const
+{
+	return (uint32_t(std::min(std::max(numPointLights, 0), int(MAX_POINT_LIGHTS))) & NUM_POINT_LIGHTS_MASK)
+		| (hasDirLight ? DIR_LIGHT_BIT : 0u)
+		| (hasSpecularMap ? SPECULAR_MAP_BIT : 0u)
+		| (instanced ? INSTANCED_BIT : 0u)
+		| (legacyNormalMatrix ? LEGACY_NORMAL_MATRIX_BIT : 0u)
+		| (clustered ? CLUSTERED_BIT : 0u)
+		| (gbuffer ? GBUFFER_BIT : 0u)
+		| (lightCulling ? LIGHT_CULLING_BIT : 0u)
+		| (shadows ? SHADOWS_BIT : 0u)
+		| (textureArrays ? TEXTURE_ARRAYS_BIT : 0u);
+}
+
+std::string LightingPermutation::getDefines() const
+{
+	const auto clampedNumPointLights = std::min(std::max(numPointLights, 0), int(MAX_POINT_LIGHTS));
+	std::string result = "#define NR_POINT_LIGHTS " + std::to_string(clampedNumPointLights) + "\n";
+	if (hasDirLight) {
+		result += "#define HAS_DIR_LIGHT\n";
+	}
+	if (hasSpecularMap) {
+		result += "#define HAS_SPECULAR_MAP\n";
+	}
+	if (clustered) {
+		result += "#define CLUSTERED_LIGHTING\n";
+	}
+	if (lightCulling) {
+		result += "#define LIGHT_CULLING\n";
+	}
+	if (shadows) {
+		result += "#define SHADOWS\n";
+	}
+	if (textureArrays) {
+		result += "#define TEXTURE_ARRAYS\n";
+	}
+	if (gbuffer) {
+		result += "#define GBUFFER_PASS\n";
+	}
+	if (legacyNormalMatrix) {
+		result += "#define LEGACY_NORMAL_MATRIX\n";
+	}
+	return result;
+}
+
+LightingShaderCache::LightingShaderCache(ProgramBinaryCache* binaryCache)
+	: _binaryCache(binaryCache)
+{
+}
+
+Shader* LightingShaderCache::get(const LightingPermutation& permutation)
+{
+	const auto program = request(permutation);
+	const auto it = std::find(_pending.begin(), _pending.end(), program);
+	if (it != _pending.end())
+	{
+		_pending.erase(it);
+		setUp(*program);
+	}
+	return program;
+}
+
+Shader* LightingShaderCache::request(const LightingPermutation& permutation)
+{
+	const auto key = permutation.getKey();
+	const auto it = _programs.find(key);
+	if (it != _programs.end())
+	{
+		_hits++;
+		return it->second.get();
+	}
+
+	const char* vertexPath = permutation.instanced ? "res/shaders/multiple_lights_instanced.vs" : "res/shaders/multiple_lights.vs";
+	auto program = std::make_unique<Shader>(vertexPath, "res/shaders/multiple_lights.fs", nullptr, permutation.getDefines(), _binaryCache);
+
+	auto result = program.get();
+	_programs.emplace(key, std::move(program));
+	_pending.push_back(result);
+	if (_hotReload != nullptr) {
+		_hotReload->add(result, [this](Shader& program) { setUp(program); });
+	}
+	return result;
+}
+
+void LightingShaderCache::setHotReload(ShaderHotReload* hotReload)
+{
+	for (const auto& program : _programs)
+	{
+		if (_hotReload != nullptr) {
+			_hotReload->remove(program.second.get());
+		}
+		if (hotReload != nullptr) {
+			hotReload->add(program.second.get(), [this](Shader& program) { setUp(program); });
+		}
+	}
+	_hotReload = hotReload;
+}
+
+void LightingShaderCache::finishPending()
+{
+	// with parallel compile, programs are set up as they complete; without it, all of them are complete right away
+	while (!_pending.empty())
+	{
+		const auto it = std::find_if(_pending.begin(), _pending.end(), [](const Shader* program) { return program->isLinkComplete(); });
+		if (it == _pending.end())
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		const auto program = *it;
+		_pending.erase(it);
+		setUp(*program);
+	}
+}
+
+void LightingShaderCache::setUp(Shader& program)
+{
+	// tell opengl for each sampler to which texture unit it belongs to, material is the same for everything
+	program.use();
+	program.setInt("material.diffuse", 0);
+	program.setInt("material.specular", 1);
+	program.setFloat("material.shininess", 32.0f);
+	program.bindUniformBlock("FrameData", FRAME_BLOCK_BINDING);
+	program.bindUniformBlock("LightData", LIGHT_BLOCK_BINDING);
+	program.bindUniformBlock("ClusterData", CLUSTER_BLOCK_BINDING);
+	program.setInt("clusterLights", CLUSTER_LIGHTS_TEXTURE_UNIT);
+	program.setInt("clusterGrid", CLUSTER_GRID_TEXTURE_UNIT);
+	program.setInt("clusterLightIndices", CLUSTER_LIGHT_INDICES_TEXTURE_UNIT);
+	program.bindUniformBlock("ShadowData", SHADOW_BLOCK_BINDING);
+	program.setInt("shadowAtlas", SHADOW_ATLAS_TEXTURE_UNIT);
+}
+
+size_t LightingShaderCache::getNumPrograms() const
+{
+	return _programs.size();
+}
+
+void LightingShaderCache::printStats(std::ostream& os) const
+{
+	os << "Lighting shader cache: " << _programs.size() << " permutations compiled, " << _hits << " hits (";
+	auto first = true;
+	for (const auto& program : _programs)
+	{
+		const auto key = program.first;
+		os << (first ? "" : ", ") << (key & NUM_POINT_LIGHTS_MASK) << " point lights"
+			<< ((key & DIR_LIGHT_BIT) != 0 ? " + dir light" : "")
+			<< ((key & SPECULAR_MAP_BIT) != 0 ? " + specular map" : "")
+			<< ((key & INSTANCED_BIT) != 0 ? " instanced" : "")
+			<< ((key & CLUSTERED_BIT) != 0 ? " clustered" : "")
+			<< ((key & GBUFFER_BIT) != 0 ? " G-buffer" : "")
+			<< ((key & LIGHT_CULLING_BIT) != 0 ? " culled" : "")
+			<< ((key & SHADOWS_BIT) != 0 ? " shadowed" : "")
+			<< ((key & TEXTURE_ARRAYS_BIT) != 0 ? " texture arrays" : "")
+			<< ((key & LEGACY_NORMAL_MATRIX_BIT) != 0 ? " legacy normal matrix" : "");
+		first = false;
+	}
+	os << ")" << std::endl;
+}
+
+void LightingShaderCache::clear()
+{
+	for (const auto& program : _programs)
+	{
+		if (_hotReload != nullptr) {
+			_hotReload->remove(program.second.get());
+		}
+		program.second->deleteProgram();
+	}
+	_programs.clear();
+	_pending.clear();
+}
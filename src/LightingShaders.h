@@ -0,0 +1,83 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Project
+#include "shader.h"
+#include "ShaderHotReload.h"
+
+/**
+  Features one permutation of the lighting program (multiple_lights.fs) is compiled with.
+  Everything left out is compiled out of the fragment shader, so objects pay only for what they use.
+*/
+struct LightingPermutation
+{
+	int numPointLights = 0; //! Point lights evaluated (NR_POINT_LIGHTS), 0..MAX_POINT_LIGHTS
+	bool hasDirLight = false; //! Directional light is evaluated (HAS_DIR_LIGHT)
+	bool hasSpecularMap = false; //! Specular map is sampled and specular terms are added (HAS_SPECULAR_MAP)
+	bool instanced = false; //! Per-instance model matrix attributes (multiple_lights_instanced.vs)
+	bool clustered = false; //! Lights are taken from the froxel grid of ClusteredLighting instead of LightData block (CLUSTERED_LIGHTING)
+	bool lightCulling = false; //! Only lights of the object's list are evaluated (LIGHT_CULLING), see LightCulling
+	bool shadows = false; //! Point lights are shadowed from the shadow atlas of ShadowMaps (SHADOWS)
+	bool textureArrays = false; //! Material maps are layers of TextureArrays, sampled at the object's layer and rectangle (TEXTURE_ARRAYS)
+	bool gbuffer = false; //! Material and normal are written into the G-buffer of DeferredShading instead of lighting (GBUFFER_PASS)
+	bool legacyNormalMatrix = false; //! Normal matrix inverted per vertex instead of supplied by the CPU (LEGACY_NORMAL_MATRIX), for comparison only
+
+	/** \brief Gets key identifying the permutation in the cache. */
+	uint32_t getKey() const;
+
+	/** \brief Gets #define lines to inject into the shader sources. */
+	std::string getDefines() const;
+};
+
+/**
+  Lighting programs compiled on first request for every permutation, then shared by all their users.
+  Every program has its samplers assigned and uniform blocks bound right after it's compiled.
+*/
+class LightingShaderCache
+{
+public:
+	/** \brief Creates empty cache, programs are linked from binaries of given cache whenever possible. */
+	explicit LightingShaderCache(ProgramBinaryCache* binaryCache = nullptr);
+	LightingShaderCache(const LightingShaderCache&) = delete;
+	LightingShaderCache& operator=(const LightingShaderCache&) = delete;
+
+	/** \brief Gets program of given permutation, compiles it if it does not exist yet (and waits for it). */
+	Shader* get(const LightingPermutation& permutation);
+
+	/** \brief Gets program of given permutation, only submits its compilation if it does not exist yet.
+	*   The program can't be used before finishPending has been called.
+	*/
+	Shader* request(const LightingPermutation& permutation);
+
+	/** \brief Registers all programs, present and future, for hot reload (null to stop). */
+	void setHotReload(ShaderHotReload* hotReload);
+
+	/** \brief Waits for all submitted programs, taking them in the order the driver finishes them, and sets them up. */
+	void finishPending();
+
+	/** \brief Gets number of programs compiled so far. */
+	size_t getNumPrograms() const;
+
+	/** \brief Prints compiled permutations in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+	/** \brief Deletes all programs (the OpenGL context must still exist). */
+	void clear();
+
+private:
+	std::unordered_map<uint32_t, std::unique_ptr<Shader>> _programs; // Keyed by LightingPermutation::getKey()
+	std::vector<Shader*> _pending; // Programs submitted, but not set up yet
+	ProgramBinaryCache* _binaryCache; // Optional on-disk cache of linked programs
+	ShaderHotReload* _hotReload = nullptr; // Optional reloading of changed sources
+	uint64_t _hits = 0; // Requests served by already compiled program
+
+	/** \brief Sets samplers, material constants and uniform blocks of the freshly linked program. */
+	void setUp(Shader& program);
+};
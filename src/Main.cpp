@@ -1,54 +1,60 @@
-#include "ShapeGenerator.h"
-#include "ShapeData.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
 #include <vector>
+#include <memory>
 
 #include "shader.h"
 #include "camera.h"
-#include "cylinder.h"
+#include "BakedTexture.h"
+#include "Benchmark.h"
+#include "ClusteredLighting.h"
+#include "DeferredShading.h"
+#include "Framebuffer.h"
+#include "GLDebug.h"
+#include "HeadlessContext.h"
+#include "LightCulling.h"
+#include "LightingShaders.h"
+#include "ParallelShaderCompile.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderHotReload.h"
+#include "ShadowMaps.h"
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include "TextureStorage.h"
+#include "TextureStreamer.h"
+#include "CylinderBatch.h"
+#include "MeshCache.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "SceneResources.h"
+#include "UniformBlocks.h"
 
 #include <iostream>
 
-/* Dynamic error handling */
-#define ASSERT(x) if(!(x)) __debugbreak();
-#define GLCall(x) GLClearError();\
-    x;\
-    ASSERT(GLLogCall(#x, __FILE__, __LINE__))
-
-static void GLClearError()
-{
-	while (glGetError() != GL_NO_ERROR);
-}
-
-static bool GLLogCall(const char* function, const char* file, int line)
-{
-	while (GLenum error = glGetError())
-	{
-		std::cout << "[OpenGL Error] (" << error << ")\n"
-			<< function << " " << file << ":" << line << std::endl;
-		return false;
-	}
-	return true;
-}
-
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
+// scene files, the baked one is preferred while it's up to date
+const char* DEFAULT_SCENE_PATH = "res/scenes/default.scene";
+const char* DEFAULT_BAKED_SCENE_PATH = "res/scenes/default.sceneb";
+
 // camera
 Camera camera(glm::vec3(1.0f, 3.0f, 5.0f));
 float lastX = SCR_WIDTH / 2.0f;
@@ -57,235 +63,569 @@ bool firstMouse = true;
 
 bool perspective = true;
 
+// draw cylinders with instanced batches instead of one mesh per cylinder (toggle with I)
+bool instancedCylinders = true;
+
+// shade lit objects from a G-buffer instead of forward (toggle with G)
+bool deferredShading = false;
+
+// time the texture loader may spend uploading decoded images in an interactive frame
+const double TEXTURE_UPLOAD_BUDGET_MS = 2.0;
+// time the texture streamer may spend streaming in finer mip levels in a frame
+const double TEXTURE_STREAMING_BUDGET_MS = 1.0;
+
+// benchmark: frames rendered before measuring starts, fixed timestep of the camera path
+const int BENCHMARK_WARMUP_FRAMES = 30;
+const float BENCHMARK_TIMESTEP = 1.0f / 60.0f;
+
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-// offset variables for plane, sphere
-const uint NUM_VERTICES_PER_TRI = 3;
-const uint NUM_FLOATS_PER_VERTICE = 9;
-const uint VERTEX_BYTE_SIZE = NUM_FLOATS_PER_VERTICE * sizeof(float);
-
-// plane
-GLuint planeNumIndices;
-GLuint planeVertexArrayObjectID;
-GLuint planeIndexByteOffset;
-
-// sphere
-GLuint sphereNumIndices;
-GLuint sphereVertexArrayObjectID;
-GLuint sphereIndexByteOffset;
+// size of the default framebuffer (clustered lighting maps pixels to screen tiles)
+int viewportWidth = SCR_WIDTH;
+int viewportHeight = SCR_HEIGHT;
 
 // projection matrix
 glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 
-int main()
+// picks the baked default scene if it's newer than its text source, the text one otherwise
+std::string defaultScenePath()
 {
-	// glfw: initialize and configure
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	std::error_code error;
+	const auto textTime = std::filesystem::last_write_time(DEFAULT_SCENE_PATH, error);
+	if (error) {
+		return DEFAULT_SCENE_PATH;
+	}
+	const auto bakedTime = std::filesystem::last_write_time(DEFAULT_BAKED_SCENE_PATH, error);
+	return !error && bakedTime >= textTime ? DEFAULT_BAKED_SCENE_PATH : DEFAULT_SCENE_PATH;
+}
+
+int main(int argc, char** argv)
+{
+	// command line: [--scene path] [--bake-scene input output] [--headless WxH [--frames n] [--output image.ppm]]
+	//               [--benchmark frames [--benchmark-output report.json]] [--bench-uniforms iterations] [--bench-normal-matrix iterations]
+	//               [--shader-cache directory | --no-shader-cache] [--no-hot-reload] [--clustered] [--deferred]
+	//               [--no-light-culling] [--no-shadows] [--no-async-textures] [--bake-texture image output.texb]
+	//               [--texture-arrays] [--texture-streaming budgetMiB]
+	std::string scenePath;
+	std::string shaderCacheDirectory = "cache/shaders";
+	bool hotReloadShaders = true;
+	bool clusteredLightingRequested = false;
+	bool lightCullingEnabled = true;
+	bool shadowsEnabled = true;
+	bool asyncTextures = true;
+	bool textureArrays = false;
+	int textureStreamingBudgetMiB = 0;
+	int uniformBenchmarkIterations = 0;
+	int normalMatrixBenchmarkIterations = 0;
+	int benchmarkFrames = 0;
+	std::string benchmarkOutputPath;
+	int headlessWidth = 0, headlessHeight = 0;
+	int headlessFrames = 1;
+	std::string headlessOutputPath;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--scene" && i + 1 < argc) {
+			scenePath = argv[++i];
+		}
+		else if (argument == "--bake-scene" && i + 2 < argc)
+		{
+			// converts the text scene to its binary form and quits, no OpenGL needed
+			Scene scene;
+			if (!scene.loadText(argv[i + 1]) || !scene.saveBinary(argv[i + 2])) {
+				return -1;
+			}
+			std::cout << "Baked scene " << argv[i + 1] << " into " << argv[i + 2] << std::endl;
+			return 0;
+		}
+		else if (argument == "--bake-texture" && i + 2 < argc)
+		{
+			// block compresses the image with all of its mipmaps and quits, textures pick it up next to their image
+			if (!bakeTexture(argv[i + 1], argv[i + 2])) {
+				return -1;
+			}
+			std::cout << "Baked texture " << argv[i + 1] << " into " << argv[i + 2] << std::endl;
+			return 0;
+		}
+		else if (argument == "--headless" && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &headlessWidth, &headlessHeight) == 2
+			&& headlessWidth > 0 && headlessHeight > 0) {
+			i++;
+		}
+		else if (argument == "--frames" && i + 1 < argc && (headlessFrames = atoi(argv[i + 1])) > 0) {
+			i++;
+		}
+		else if (argument == "--output" && i + 1 < argc) {
+			headlessOutputPath = argv[++i];
+		}
+		else if (argument == "--benchmark" && i + 1 < argc && (benchmarkFrames = atoi(argv[i + 1])) > 0) {
+			i++;
+		}
+		else if (argument == "--benchmark-output" && i + 1 < argc) {
+			benchmarkOutputPath = argv[++i];
+		}
+		else if (argument == "--shader-cache" && i + 1 < argc) {
+			shaderCacheDirectory = argv[++i];
+		}
+		else if (argument == "--no-shader-cache") {
+			shaderCacheDirectory.clear();
+		}
+		else if (argument == "--no-hot-reload") {
+			hotReloadShaders = false;
+		}
+		else if (argument == "--clustered") {
+			clusteredLightingRequested = true;
+		}
+		else if (argument == "--deferred") {
+			deferredShading = true;
+		}
+		else if (argument == "--no-light-culling") {
+			lightCullingEnabled = false;
+		}
+		else if (argument == "--no-shadows") {
+			shadowsEnabled = false;
+		}
+		else if (argument == "--no-async-textures") {
+			asyncTextures = false;
+		}
+		else if (argument == "--texture-arrays") {
+			textureArrays = true;
+		}
+		else if (argument == "--texture-streaming" && i + 1 < argc && (textureStreamingBudgetMiB = atoi(argv[i + 1])) > 0) {
+			i++;
+		}
+		else if (argument == "--bench-uniforms" && i + 1 < argc && (uniformBenchmarkIterations = atoi(argv[i + 1])) > 0) {
+			i++;
+		}
+		else if (argument == "--bench-normal-matrix" && i + 1 < argc && (normalMatrixBenchmarkIterations = atoi(argv[i + 1])) > 0) {
+			i++;
+		}
+		else
+		{
+			std::cout << "Usage: " << argv[0] << " [--scene path] [--bake-scene input output] [--bake-texture image output.texb]"
+				<< " [--headless WxH [--frames n] [--output image.ppm]]"
+				<< " [--benchmark frames [--benchmark-output report.json]] [--bench-uniforms iterations] [--bench-normal-matrix iterations]"
+				<< " [--shader-cache directory | --no-shader-cache] [--no-hot-reload] [--clustered] [--deferred]"
+				<< " [--no-light-culling] [--no-shadows] [--no-async-textures] [--texture-arrays] [--texture-streaming budgetMiB]" << std::endl;
+			return -1;
+		}
+	}
+	if (scenePath.empty()) {
+		scenePath = defaultScenePath();
+	}
+	const bool headless = headlessWidth > 0;
+	const bool interactive = !headless && benchmarkFrames == 0 && uniformBenchmarkIterations == 0 && normalMatrixBenchmarkIterations == 0;
+	const GLADloadproc loadProc = headless ? (GLADloadproc)HeadlessContext::getProcAddress : (GLADloadproc)glfwGetProcAddress;
+
+	// headless mode renders into an offscreen framebuffer of a context without any window
+	GLFWwindow* window = NULL;
+	HeadlessContext headlessContext;
+	if (headless)
+	{
+		if (!headlessContext.create(headlessWidth, headlessHeight, GLDEBUG_ENABLED != 0)) {
+			return -1;
+		}
+		if (!gladLoadGLLoader(loadProc))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return -1;
+		}
+		projection = glm::perspective(glm::radians(camera.Zoom), (float)headlessWidth / (float)headlessHeight, 0.1f, 100.0f);
+		viewportWidth = headlessWidth;
+		viewportHeight = headlessHeight;
+	}
+	else
+	{
+		// glfw: initialize and configure
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if GLDEBUG_ENABLED
+		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
 
 #ifdef __APPLE__
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-	// glfw window creation
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Module 6: OpenGL Lights", NULL, NULL);
-	if (window == NULL)
+		// glfw window creation
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Module 6: OpenGL Lights", NULL, NULL);
+		if (window == NULL)
+		{
+			std::cout << "Failed to create GLFW window" << std::endl;
+			glfwTerminate();
+			return -1;
+		}
+		glfwMakeContextCurrent(window);
+		glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		glfwSetCursorPosCallback(window, mouse_callback);
+		glfwSetScrollCallback(window, scroll_callback);
+		glfwSetKeyCallback(window, key_callback);
+
+		// tell GLFW to capture our mouse
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+		// glad: load all OpenGL function pointers
+		if (!gladLoadGLLoader(loadProc))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return -1;
+		}
+	}
+
+	// releases the window system (the OpenGL context goes away with it)
+	auto terminate = [&]()
 	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
+		if (headless) {
+			headlessContext.destroy();
+		}
+		else {
+			glfwTerminate();
+		}
+	};
+
+	// errors are reported by the driver through debug output callback (debug builds only)
+	GL_DEBUG_INITIALIZE(loadProc);
+	ParallelShaderCompile::initialize(loadProc);
+	TextureStorage::initialize(loadProc);
+
+	// configure global opengl state
+	glEnable(GL_DEPTH_TEST);
+
+	Framebuffer framebuffer;
+	if (headless)
+	{
+		if (!framebuffer.create(headlessWidth, headlessHeight))
+		{
+			terminate();
+			return -1;
+		}
+		framebuffer.bind();
+	}
+
+	// lighting programs are compiled per permutation on first use, each object gets the cheapest one for its material
+	// linked programs are kept on disk, so that next start skips compiling them
+	ProgramBinaryCache programBinaries;
+	if (!shaderCacheDirectory.empty()) {
+		programBinaries.initialize(shaderCacheDirectory, loadProc);
+	}
+	LightingShaderCache lightingShaders(&programBinaries);
+	Shader lightCubeShader("res/shaders/light_cube.vs", "res/shaders/light_cube.fs", nullptr, std::string(), &programBinaries);
+
+	// camera and lights live in uniform buffers shared by all programs through binding points
+	UniformBuffer frameUniforms, lightUniforms;
+	frameUniforms.create("FrameData", FRAME_BLOCK_BINDING, sizeof(FrameBlock));
+	lightUniforms.create("LightData", LIGHT_BLOCK_BINDING, sizeof(LightBlock));
+
+	// load the scene and build all of its GPU resources at once, the mesh cache shares cylinders between them
+	const auto loadStart = std::chrono::steady_clock::now();
+	Scene scene;
+	static_meshes_3D::MeshCache meshCache;
+	auto sceneResources = std::make_unique<SceneResources>();
+	const auto sceneLoaded = scene.load(scenePath);
+
+	// images are decoded in the background, so the first frame does not wait for them,
+	// the texture cache loads every image once no matter how many materials use it
+	TextureLoader textureLoader;
+	if (asyncTextures) {
+		textureLoader.create();
+	}
+	// baked textures start with their small mip levels, finer ones come as objects get close enough to need them
+	const bool textureStreaming = textureStreamingBudgetMiB > 0;
+	TextureStreamer textureStreamer;
+	if (textureStreaming) {
+		textureStreamer.create(uint64_t(textureStreamingBudgetMiB) * 1024 * 1024);
+	}
+	TextureCache textureCache(asyncTextures ? &textureLoader : nullptr, textureStreaming ? &textureStreamer : nullptr);
+
+	// scenes with more lights than the LightData block holds are lit through the froxel grid
+	const bool useClusteredLighting = sceneLoaded && (clusteredLightingRequested || scene.getNumLights() > MAX_POINT_LIGHTS);
+	// otherwise every lit object gets the list of lights reaching it, so that it evaluates only those
+	LightCulling lightCulling;
+	const bool useLightCulling = sceneLoaded && lightCullingEnabled && !useClusteredLighting;
+	if (useLightCulling) {
+		lightCulling.setLights(scene);
+	}
+	// the first lights of forward lit scenes cast shadows
+	const bool useShadows = sceneLoaded && shadowsEnabled && !useClusteredLighting && scene.getNumLights() > 0;
+	// G-buffer programs are always prepared, so that deferred shading can be toggled at any time,
+	// texture arrays are packed right away (they bypass the texture cache and its loader)
+	if (!sceneLoaded || !sceneResources->create(scene, meshCache, textureCache,
+		{ &lightingShaders, &lightCubeShader, useClusteredLighting, useLightCulling ? &lightCulling : nullptr, useShadows, true, textureArrays }))
+	{
+		sceneResources.reset();
+		textureLoader.deleteResources();
+		textureCache.deleteResources();
+		lightingShaders.clear();
+		frameUniforms.deleteBuffer();
+		lightUniforms.deleteBuffer();
+		framebuffer.deleteFramebuffer();
+		terminate();
 		return -1;
 	}
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	// programs have been compiling alongside meshes and textures, this is their first use
+	lightingShaders.finishPending();
+	lightCubeShader.bindUniformBlock("FrameData", FRAME_BLOCK_BINDING);
+
+	// lights of deferred shading are volumes drawn over the G-buffer, one instance per light
+	DeferredShading deferred;
+	deferred.create(&programBinaries);
+	deferred.setLights(scene);
+
+	// shadows of static objects are cached, dynamic ones are composited every frame
+	ShadowMaps shadowMaps;
+	if (useShadows)
+	{
+		shadowMaps.create(&programBinaries);
+		shadowMaps.setLights(scene);
+	}
 
-	// tell GLFW to capture our mouse
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// interactive sessions pick up edited shaders without restart, rebuilt programs get their bindings back
+	ShaderHotReload shaderHotReload;
+	if (interactive && hotReloadShaders && shaderHotReload.initialize("res/shaders"))
+	{
+		lightingShaders.setHotReload(&shaderHotReload);
+		deferred.setHotReload(&shaderHotReload);
+		shadowMaps.setHotReload(&shaderHotReload);
+		shaderHotReload.add(&lightCubeShader, [](Shader& program) { program.bindUniformBlock("FrameData", FRAME_BLOCK_BINDING); });
+	}
+	const std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+	std::cout << "Scene " << scenePath << " loaded in " << loadTime.count() << " ms" << std::endl;
+	meshCache.printStats(std::cout);
+	textureCache.printStats(std::cout);
+	if (textureArrays) {
+		sceneResources->getTextureArrays().printStats(std::cout);
+	}
+	lightingShaders.printStats(std::cout);
+	programBinaries.printStats(std::cout);
+	if (useLightCulling) {
+		lightCulling.printStats(std::cout);
+	}
 
-	// glad: load all OpenGL function pointers
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	ClusteredLighting clusteredLighting;
+	if (useClusteredLighting)
 	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
-		return -1;
+		clusteredLighting.create();
+		clusteredLighting.setLights(scene);
+		std::cout << "Scene has " << scene.getNumLights() << " lights, using clustered lighting" << std::endl;
 	}
 
-	// configure global opengl state
-	GLCall(glEnable(GL_DEPTH_TEST));
-
-	Shader lightingShader("res/shaders/multiple_lights.vs", "res/shaders/multiple_lights.fs");
-	Shader lightCubeShader("res/shaders/light_cube.vs", "res/shaders/light_cube.fs");
-
-	float vertices[] = {
-		// positions          // normals           // texture coords
-		//Front Face
-		-1.8f,	0.0f, -0.70f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, 
-		 1.8f,  0.0f, -0.70f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
-		 1.8f, 0.45f, -0.70f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f, 
-		 1.8f, 0.45f, -0.70f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
-		-1.8f, 0.45f, -0.70f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
-		-1.8f,  0.0f, -0.70f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, 
-		// Back face
-		-1.8f,  0.0f,  0.70f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-		 1.8f,  0.0f,  0.70f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
-		 1.8f, 0.45f,  0.70f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-		 1.8f, 0.45f,  0.70f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-		-1.8f, 0.45f,  0.70f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
-		-1.8f,  0.0f,  0.70f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-
-		-1.8f, 0.45f,  0.70f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-		-1.8f, 0.45f, -0.70f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-		-1.8f,  0.0f, -0.70f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-		-1.8f,  0.0f, -0.70f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-		-1.8f,  0.0f,  0.70f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-		-1.8f, 0.45f,  0.70f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
-		 1.8f, 0.45f,  0.70f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-		 1.8f, 0.45f, -0.70f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-		 1.8f,  0.0f, -0.70f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-		 1.8f,  0.0f, -0.70f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-		 1.8f,  0.0f,  0.70f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-		 1.8f, 0.45f,  0.70f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-	
-		-1.8f, -0.0f, -0.70f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-		 1.8f, -0.0f, -0.70f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
-		 1.8f, -0.0f,  0.70f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-		 1.8f, -0.0f,  0.70f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-		-1.8f, -0.0f,  0.70f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
-		-1.8f, -0.0f, -0.70f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-
-		-1.8f, 0.45f, -0.70f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
-		 1.8f, 0.45f, -0.70f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
-		 1.8f, 0.45f,  0.70f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-		 1.8f, 0.45f,  0.70f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-		-1.8f, 0.45f,  0.70f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
-		-1.8f, 0.45f, -0.70f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
-	};
+	// scene lights are static, so their block gets uploaded once (unused lights stay black)
+	LightBlock lightBlock = {};
+	for (unsigned int i = 0; i < MAX_POINT_LIGHTS && i < scene.getNumLights(); i++)
+	{
+		const auto& light = scene.getLight(i);
+		auto& block = lightBlock.pointLights[i];
+		block.position = light.position;
+		block.constant = light.constant;
+		block.ambient = light.ambient;
+		block.linear = light.linear;
+		block.diffuse = light.diffuse;
+		block.quadratic = light.quadratic;
+		block.specular = light.specular;
+	}
+	for (unsigned int i = scene.getNumLights(); i < MAX_POINT_LIGHTS; i++) {
+		lightBlock.pointLights[i].constant = 1.0f;
+	}
+	lightUniforms.update(&lightBlock);
 
-	// positions of the point lights
-	glm::vec3 pointLightPositions[] = {
-		glm::vec3(0.8f,  2.8f,  -1.2f),
-		glm::vec3(2.5f, 1.0f, -1.0f)
-	};
+	// benchmarks and headless images must show the final textures from their first frame
+	if (!interactive)
+	{
+		textureLoader.finish();
+		if (textureStreaming)
+		{
+			textureStreamer.beginFrame();
+			sceneResources->requestTextureLevels(textureStreamer, camera.Position, projection, viewportHeight);
+			textureStreamer.finish();
+		}
+	}
+
+	RenderQueue renderQueue;
+
+	// renders one frame into the currently bound framebuffer, the same for window and headless mode
+	float sceneTime = 0.0f;
+	auto renderFrame = [&]()
+	{
+		GL_DEBUG_GROUP("Frame");
+
+		// Sets the background color of the window to black (it will be implicitely used by glClear)
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// view/projection transformations, one upload for all programs (skipped while the camera stands still)
+		FrameBlock frameBlock;
+		frameBlock.projection = projection;
+		frameBlock.view = camera.GetViewMatrix();
+		frameBlock.viewPos = glm::vec4(camera.Position, 1.0f);
+		frameUniforms.update(&frameBlock);
+		lightUniforms.update(&lightBlock);
+		if (useClusteredLighting) {
+			clusteredLighting.update(frameBlock.view, projection, 0.1f, 100.0f, viewportWidth, viewportHeight);
+		}
+
+		// streamed textures get the levels the camera needs now, the least recently needed ones make room for them
+		if (textureStreaming)
+		{
+			textureStreamer.beginFrame();
+			sceneResources->requestTextureLevels(textureStreamer, camera.Position, projection, viewportHeight);
+			textureStreamer.update(TEXTURE_STREAMING_BUDGET_MS);
+		}
+
+		// dynamic objects move on, their shadows follow (the deferred path has no shadows)
+		sceneTime += deltaTime;
+		sceneResources->update(sceneTime);
+		if (useShadows && !deferredShading) {
+			shadowMaps.update(*sceneResources);
+		}
 
-	glm::vec3 pointLightColors[] = {
-		glm::vec3(1.0f, 0.6f, 0.0f),
-		glm::vec3(0.0f, 0.5f, 1.0f)
+		// submit everything and let the queue order the draws
+		renderQueue.resetStats();
+		renderQueue.setCamera(camera.Position, camera.Front, 100.0f);
+		if (!deferredShading)
+		{
+			sceneResources->submit(renderQueue, instancedCylinders);
+			renderQueue.flush();
+		}
+		else
+		{
+			// lit objects fill the G-buffer, lights shade it, unlit ones are drawn on top, then it all goes to the target
+			GLint targetFramebuffer = 0;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+			if (deferred.resize(viewportWidth, viewportHeight))
+			{
+				deferred.beginGeometryPass();
+				sceneResources->submit(renderQueue, instancedCylinders, SCENE_PASS_GBUFFER);
+				renderQueue.flush();
+				deferred.renderLights(frameBlock.view, projection);
+				deferred.beginForwardPass();
+				sceneResources->submit(renderQueue, instancedCylinders, SCENE_PASS_UNLIT);
+				renderQueue.flush();
+				deferred.resolve(GLuint(targetFramebuffer));
+			}
+		}
+
+		GL_CHECK_ERRORS("renderFrame");
 	};
 
-	// cup handle cube's VAO and VBO
-	unsigned int cubeVBO, cubeVAO;
-	GLCall(glGenVertexArrays(1, &cubeVAO));
-	GLCall(glGenBuffers(1, &cubeVBO));
-
-	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	glBindVertexArray(cubeVAO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-
-	// position attribute for cube
-	GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0));
-	GLCall(glEnableVertexAttribArray(0));
-	// texture attribute for cube
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	GLCall(glEnableVertexAttribArray(1));
-	// normal attribute for cube
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
-	GLCall(glEnableVertexAttribArray(2));
-
-
-	// lightCube's VAO and VBO
-	unsigned int lightCubeVAO, lightCubeVBO;
-	glGenVertexArrays(1, &lightCubeVAO);
-	glGenBuffers(1, &lightCubeVBO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, lightCubeVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	GLCall(glGenVertexArrays(1, &lightCubeVAO));
-	GLCall(glBindVertexArray(lightCubeVAO));
-
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, lightCubeVBO));
-	// note that we update the lamp's position attribute's stride to reflect the updated buffer data
-	GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0));
-	GLCall(glEnableVertexAttribArray(0));
-
-	// creates plane object
-	ShapeData plane = ShapeGenerator::makePlane(10);
-
-	unsigned int planeVBO{}, planeVAO;
-	GLCall(glGenVertexArrays(1, &planeVAO));
-	GLCall(glGenBuffers(1, &planeVBO));
-
-	GLCall(glBindVertexArray(planeVAO));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, planeVBO));
-	GLCall(glBufferData(GL_ARRAY_BUFFER, plane.vertexBufferSize() + plane.indexBufferSize(), 0, GL_STATIC_DRAW));
-
-	GLsizeiptr currentOffset = 0;
-
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, plane.vertexBufferSize(), plane.vertices);
-	currentOffset += plane.vertexBufferSize();
-
-	planeIndexByteOffset = currentOffset;
-
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, plane.indexBufferSize(), plane.indices);
-
-	planeNumIndices = plane.numIndices;
-
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 3));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 6));
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeVBO);
-
-	// Creating of the sphere object 
-	ShapeData sphere = ShapeGenerator::makeSphere();
-	unsigned int sphereVBO{}, sphereVAO;
-	glGenVertexArrays(1, &sphereVAO);
-	glGenBuffers(1, &sphereVBO);
-	glBindVertexArray(sphereVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-	glBufferData(GL_ARRAY_BUFFER, sphere.vertexBufferSize() + sphere.indexBufferSize(), 0, GL_STATIC_DRAW);
-	currentOffset = 0;
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, sphere.vertexBufferSize(), sphere.vertices);
-	currentOffset += sphere.vertexBufferSize();
-	sphereIndexByteOffset = currentOffset;
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, sphere.indexBufferSize(), sphere.indices);
-	sphereNumIndices = sphere.numIndices;
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 3));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 6));
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereVBO);
-
-	// load textures using utility function
-	unsigned int cubeDiffuseMap = loadTexture("images/metal.jpg");
-	unsigned int planeDiffuseMap = loadTexture("images/wrinkle_paper.jpg");
-	unsigned int sphereDiffuseMap = loadTexture("images/red-stock.jpg");
-	unsigned int cylinderDiffuseMap = loadTexture("images/metal.jpg");
-
-	// tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
-	lightingShader.use();
-	lightingShader.setInt("material.diffuse", 0);
-	lightingShader.setInt("material.specular", 1);
+	if (uniformBenchmarkIterations > 0)
+	{
+		// uniform updates alone, old lookup by name against the location cache and handles
+		LightingPermutation permutation;
+		permutation.numPointLights = MAX_POINT_LIGHTS;
+		permutation.hasDirLight = true;
+		permutation.hasSpecularMap = true;
+		benchmarkUniforms(*lightingShaders.get(permutation), uniformBenchmarkIterations, std::cout);
+	}
+	else if (normalMatrixBenchmarkIterations > 0)
+	{
+		// vertex stage alone on the densest cylinder, one per draw and a batch of instances
+		const auto cylinder = meshCache.getCylinder(1.0f, 500, 1.0f);
+		static_meshes_3D::CylinderBatch batch(cylinder);
+		for (auto i = 0; i < 64; i++) {
+			batch.addInstance(glm::translate(glm::mat4(1.0f), glm::vec3(float(i % 8), 0.0f, float(i / 8))), 0.5f, 2.0f);
+		}
+		batch.uploadInstances();
+
+		LightingPermutation permutation;
+		permutation.numPointLights = MAX_POINT_LIGHTS;
+		permutation.hasSpecularMap = true;
+		benchmarkNormalMatrix(lightingShaders, permutation, cylinder->getVAO(), cylinder->getDrawCommand(), normalMatrixBenchmarkIterations, std::cout);
+		permutation.instanced = true;
+		benchmarkNormalMatrix(lightingShaders, permutation, batch.getVAO(), batch.getDrawCommand(), normalMatrixBenchmarkIterations, std::cout);
+	}
+	else if (benchmarkFrames > 0)
+	{
+		// the scripted camera path with fixed timestep makes every run render exactly the same frames,
+		// vsync would only measure the display, so it's off
+		if (!headless) {
+			glfwSwapInterval(0);
+		}
+
+		CameraPath cameraPath;
+		GpuTimer gpuTimer;
+		BenchmarkReport report;
+		deltaTime = BENCHMARK_TIMESTEP;
+		for (int frame = -BENCHMARK_WARMUP_FRAMES; frame < benchmarkFrames; frame++)
+		{
+			const bool measured = frame >= 0;
+			cameraPath.apply(camera, (frame + BENCHMARK_WARMUP_FRAMES) * BENCHMARK_TIMESTEP);
+
+			const auto frameStart = std::chrono::steady_clock::now();
+			if (measured) {
+				gpuTimer.begin(report.gpuFrameTimesMs);
+			}
+			renderFrame();
+			if (measured)
+			{
+				gpuTimer.end();
+				const std::chrono::duration<double, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+				report.cpuFrameTimesMs.push_back(frameTime.count());
+				report.drawCalls += uint64_t(renderQueue.getStats().drawCalls);
+				report.triangles += renderQueue.getStats().triangles;
+
+				// shadow casters and light volumes are drawn outside of the scene queue
+				if (useShadows && !deferredShading)
+				{
+					report.drawCalls += uint64_t(shadowMaps.getRenderQueueStats().drawCalls);
+					report.triangles += shadowMaps.getRenderQueueStats().triangles;
+				}
+				if (deferredShading)
+				{
+					report.drawCalls += uint64_t(deferred.getStats().drawCalls);
+					report.triangles += deferred.getStats().triangles;
+				}
+			}
+
+			if (!headless)
+			{
+				glfwSwapBuffers(window);
+				glfwPollEvents();
+			}
+		}
+		gpuTimer.finish(report.gpuFrameTimesMs);
+		report.renderer = deferredShading ? "deferred" : "forward";
+
+		const int width = headless ? headlessWidth : SCR_WIDTH;
+		const int height = headless ? headlessHeight : SCR_HEIGHT;
+		if (benchmarkOutputPath.empty()) {
+			report.writeJson(std::cout, scenePath.c_str(), width, height, BENCHMARK_TIMESTEP);
+		}
+		else
+		{
+			std::ofstream reportFile(benchmarkOutputPath);
+			report.writeJson(reportFile, scenePath.c_str(), width, height, BENCHMARK_TIMESTEP);
+			std::cout << "Benchmark report written to " << benchmarkOutputPath << std::endl;
+		}
+
+		if (headless && !headlessOutputPath.empty() && framebuffer.writePPM(headlessOutputPath)) {
+			std::cout << "Last frame written to " << headlessOutputPath << std::endl;
+		}
+	}
+	else if (headless)
+	{
+		// fixed number of frames with fixed timestep, then the last one is read back
+		const auto renderStart = std::chrono::steady_clock::now();
+		deltaTime = 1.0f / 60.0f;
+		for (int frame = 0; frame < headlessFrames; frame++) {
+			renderFrame();
+		}
+		glFinish();
+		const std::chrono::duration<double, std::milli> renderTime = std::chrono::steady_clock::now() - renderStart;
+		std::cout << "Rendered " << headlessFrames << " frames " << headlessWidth << "x" << headlessHeight
+			<< " in " << renderTime.count() << " ms" << std::endl;
+
+		if (!headlessOutputPath.empty() && framebuffer.writePPM(headlessOutputPath)) {
+			std::cout << "Last frame written to " << headlessOutputPath << std::endl;
+		}
+	}
 
 	// Render loop
-	while (!glfwWindowShouldClose(window))
+	bool firstFrame = true;
+	while (interactive && !glfwWindowShouldClose(window))
 	{
 		// per-frame time logic
 		float currentFrame = glfwGetTime();
@@ -295,160 +635,58 @@ int main()
 		// input
 		processInput(window);
 
-		// Sets the background color of the window to black (it will be implicitely used by glClear)
-		GLCall(glClearColor(0.1f, 0.1f, 0.1f, 1.0f));
-		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
-
-		lightingShader.use();
-		lightingShader.setVec3("viewPos", camera.Position);
-		lightingShader.setFloat("material.shininess", 32.0f);
-
-		// key light
-		lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-		lightingShader.setVec3("pointLights[0].ambient", pointLightColors[0]);
-		lightingShader.setVec3("pointLights[0].diffuse", 0.5f, 0.5f, 0.5f);
-		lightingShader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("pointLights[0].constant", 1.0f);
-		lightingShader.setFloat("pointLights[0].linear", 0.09);
-		lightingShader.setFloat("pointLights[0].quadratic", 0.032);
-		// fill light
-		lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-		lightingShader.setVec3("pointLights[1].ambient", pointLightColors[1]);
-		lightingShader.setVec3("pointLights[1].diffuse", 0.1f, 0.1f, 0.1f);
-		lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("pointLights[1].constant", 1.0f);
-		lightingShader.setFloat("pointLights[1].linear", 0.09);
-		lightingShader.setFloat("pointLights[1].quadratic", 0.032);
-
-		// view/projection transformations
-		glm::mat4 view = camera.GetViewMatrix();
-		lightingShader.setMat4("projection", projection);
-		lightingShader.setMat4("view", view);
-
-		// world transformation
-		glm::mat4 model = glm::mat4(1.0f);
-		lightingShader.setMat4("model", model);
-
-		// bind diffuse map
-		glActiveTexture(GL_TEXTURE0);
-		GLCall(glBindTexture(GL_TEXTURE_2D, cubeDiffuseMap));
-		GLCall(glBindVertexArray(cubeVAO));
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(4.0f, -0.43f, -2.0f));
-		lightingShader.setMat4("model", model);
-
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		// setup to draw plane
-		GLCall(glActiveTexture(GL_TEXTURE0));
-		GLCall(glBindTexture(GL_TEXTURE_2D, planeDiffuseMap));
-		GLCall(glBindVertexArray(planeVAO));
-		model = model = glm::mat4(2.0f);
-		model = glm::translate(model, glm::vec3(2.5f, -0.22f, 0.0f));
-		lightingShader.setMat4("model", model);
-
-		// draw plane
-		GLCall(glDrawElements(GL_TRIANGLES, planeNumIndices, GL_UNSIGNED_SHORT, (void*)planeIndexByteOffset));
-
-
-
-		// setup to draw sphere
-		GLCall(glBindTexture(GL_TEXTURE_2D, sphereDiffuseMap));
-		GLCall(glBindVertexArray(sphereVAO));
-		model = model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(0.0f, 0.1f, -2.0f));
-		model = glm::scale(model, glm::vec3(0.5f)); // Make it a smaller sphere
-		lightingShader.setMat4("model", model);
-
-		// draw sphere
-		GLCall(glDrawElements(GL_TRIANGLES, sphereNumIndices, GL_UNSIGNED_SHORT, (void*)sphereIndexByteOffset));
-
-		// setup to draw cylinders (battery)
-		GLCall(glBindTexture(GL_TEXTURE_2D, cylinderDiffuseMap));
-		GLCall(glBindVertexArray(sphereVAO));
-		model = model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(4.0f, 0.35f, 3.0f));
-		model = glm::scale(model, glm::vec3(0.5f));
-		lightingShader.setMat4("model", model);
-		static_meshes_3D::Cylinder C(1, 500, 3, true, true, true);
-		C.render();
-		model = glm::translate(model, glm::vec3(0.0f, 1.32f, 0.0f));
-		model = glm::scale(model, glm::vec3(0.5f)); // Make it a smaller cylinder
-		static_meshes_3D::Cylinder D(0.7, 500, 1, true, true, true);
-		lightingShader.setMat4("model", model);
-		D.render();
-
-		/* All the rendering of the pin */
-		GLCall(glBindTexture(GL_TEXTURE_2D, sphereDiffuseMap));
-		GLCall(glBindVertexArray(sphereVAO));
-		model = model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(1.5f, -0.31f, 1.0f));
-		model = glm::scale(model, glm::vec3(0.5f)); // Make it a smaller cylinder
-		static_meshes_3D::Cylinder PinBase(0.60, 200, 0.5, true, true, true);
-		lightingShader.setMat4("model", model);
-		PinBase.render();
-		model = glm::translate(model, glm::vec3(0.0f, 0.75f, 0.0f));
-		model = glm::scale(model, glm::vec3(0.5f));
-		lightingShader.setMat4("model", model);
-		static_meshes_3D::Cylinder PinHandle(0.60, 200, 2.25, true, true, true);
-		PinHandle.render();
-
-		GLCall(glBindVertexArray(sphereVAO));
-		model = model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(1.5f, 0.45f, 1.0f));
-		model = glm::scale(model, glm::vec3(0.5f));
-		lightingShader.setMat4("model", model);
-		static_meshes_3D::Cylinder TopCylinder(0.75, 200, 0.5, true, true, true);
-		TopCylinder.render();
-		GLCall(glBindTexture(GL_TEXTURE_2D, cylinderDiffuseMap));
-		model = glm::translate(model, glm::vec3(0.0f, 0.85f, 0.0f));
-		model = glm::scale(model, glm::vec3(0.5f)); // Make it a smaller cylinder
-		static_meshes_3D::Cylinder PinShaft(0.1, 200, 2.4, true, true, true);
-		lightingShader.setMat4("model", model);
-		PinShaft.render();
-
-
-		// draw the lamp object(s)
-		lightCubeShader.use();
-		lightCubeShader.setMat4("projection", projection);
-		lightCubeShader.setMat4("view", view);
-
-		// we now draw as many light bulbs as we have point lights.
-		glBindVertexArray(lightCubeVAO);
-
-		// setup to draw sphere
-		GLCall(glBindVertexArray(sphereVAO));
-		model = model = glm::mat4(1.0f);
-		model = glm::translate(model, pointLightPositions[0]);
-		model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller sphere
-		lightCubeShader.setMat4("model", model);
-		GLCall(glDrawElements(GL_TRIANGLES, sphereNumIndices, GL_UNSIGNED_SHORT, (void*)sphereIndexByteOffset));
-
-		// setup to draw sphere
-		GLCall(glBindVertexArray(sphereVAO));
-		model = model = glm::mat4(1.0f);
-		model = glm::translate(model, pointLightPositions[1]);
-		model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller sphere
-		lightCubeShader.setMat4("model", model);
-		GLCall(glDrawElements(GL_TRIANGLES, sphereNumIndices, GL_UNSIGNED_SHORT, (void*)sphereIndexByteOffset));
+		// edited shaders are swapped in once the driver has them ready, never waiting for it
+		shaderHotReload.update();
+		// decoded textures replace their placeholders, a few per frame
+		textureLoader.update(TEXTURE_UPLOAD_BUDGET_MS);
+		renderFrame();
+		if (firstFrame)
+		{
+			const std::chrono::duration<double, std::milli> firstFrameTime = std::chrono::steady_clock::now() - loadStart;
+			std::cout << "First frame rendered " << firstFrameTime.count() << " ms after loading started" << std::endl;
+			firstFrame = false;
+		}
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
+	renderQueue.printStats(std::cout);
+	std::cout << "Uniform buffers: " << frameUniforms.getNumUploads() + lightUniforms.getNumUploads() << " uploads, "
+		<< frameUniforms.getNumSkippedUploads() + lightUniforms.getNumSkippedUploads() << " skipped as unchanged" << std::endl;
+	if (useClusteredLighting) {
+		clusteredLighting.printStats(std::cout);
+	}
+	if (useShadows) {
+		shadowMaps.printStats(std::cout);
+	}
+	if (asyncTextures) {
+		textureLoader.printStats(std::cout);
+	}
+	if (textureStreaming) {
+		textureStreamer.printStats(std::cout);
+	}
 
-	// optional: de-allocate all resources once they've outlived their purpose:
-	GLCall(glDeleteVertexArrays(1, &cubeVAO));
-	GLCall(glDeleteBuffers(1, &cubeVBO));
-
-	GLCall(glDeleteVertexArrays(1, &planeVAO));
-	GLCall(glDeleteBuffers(1, &planeVBO));
-
-	GLCall(glDeleteVertexArrays(1, &sphereVAO));
-	GLCall(glDeleteBuffers(1, &sphereVBO));
+	// optional: de-allocate all resources once they've outlived their purpose
+	// (scene resources release their shared cylinders, the last handle deletes the mesh)
+	sceneResources.reset();
+	textureLoader.deleteResources();
+	textureCache.deleteResources();
+	textureStreamer.deleteResources();
+	shaderHotReload.printStats(std::cout);
+	shaderHotReload.clear();
+	lightingShaders.clear();
+	frameUniforms.deleteBuffer();
+	lightUniforms.deleteBuffer();
+	clusteredLighting.deleteResources();
+	deferred.deleteResources();
+	shadowMaps.deleteResources();
+	framebuffer.deleteFramebuffer();
+	meshCache.printStats(std::cout);
+	textureCache.printStats(std::cout);
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
-	glfwTerminate();
+	terminate();
 	return 0;
 }
 
@@ -490,6 +728,23 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 	// make sure the viewport matches the new window dimensions; note that width and 
 	// height will be significantly larger than specified on retina displays.
 	glViewport(0, 0, width, height);
+	viewportWidth = width;
+	viewportHeight = height;
+}
+
+// glfw: whenever a key is pressed, this callback is called (used for toggles, so that holding a key does not flicker)
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if (key == GLFW_KEY_I && action == GLFW_PRESS)
+	{
+		instancedCylinders = !instancedCylinders;
+		std::cout << "Instanced cylinders: " << (instancedCylinders ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_G && action == GLFW_PRESS)
+	{
+		deferredShading = !deferredShading;
+		std::cout << "Renderer: " << (deferredShading ? "deferred" : "forward") << std::endl;
+	}
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -514,40 +769,4 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
 	camera.ProcessMouseScroll(yoffset);
-}
-
-unsigned int loadTexture(char const* path)
-{
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis
-	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		GLCall(glBindTexture(GL_TEXTURE_2D, textureID));
-		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data));
-		GLCall(glGenerateMipmap(GL_TEXTURE_2D));
-
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
 }
\ No newline at end of file
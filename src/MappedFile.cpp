@@ -0,0 +1,124 @@
+// STL
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Project
+#include "MappedFile.h"
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "Could not open file " << path << " for mapping!" << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		std::cerr << "Could not map empty file " << path << "!" << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+
+	const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const auto data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (data == nullptr)
+	{
+		std::cerr << "Could not map file " << path << "!" << std::endl;
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	_fileHandle = file;
+	_mappingHandle = mapping;
+	_data = static_cast<const unsigned char*>(data);
+	_size = size_t(fileSize.QuadPart);
+#else
+	const auto file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		std::cerr << "Could not open file " << path << " for mapping!" << std::endl;
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		std::cerr << "Could not map empty file " << path << "!" << std::endl;
+		::close(file);
+		return false;
+	}
+
+	const auto data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// Mapping stays valid after closing the descriptor
+	::close(file);
+	if (data == MAP_FAILED)
+	{
+		std::cerr << "Could not map file " << path << "!" << std::endl;
+		return false;
+	}
+
+	_data = static_cast<const unsigned char*>(data);
+	_size = size_t(fileStat.st_size);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (_data == nullptr) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(_mappingHandle);
+	CloseHandle(_fileHandle);
+	_mappingHandle = nullptr;
+	_fileHandle = nullptr;
+#else
+	munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+	return _data != nullptr;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+	return _data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return _size;
+}
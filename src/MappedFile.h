@@ -0,0 +1,43 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <string>
+
+/**
+  Read-only memory mapping of a whole file, so that baked data can be used in place without parsing or copying.
+*/
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/** \brief Maps the whole file into memory (closes previously mapped file first).
+	*   \return True if the file has been mapped, false otherwise.
+	*/
+	bool open(const std::string& path);
+
+	//* \brief Unmaps the file.
+	void close();
+
+	/** \brief Checks, if a file is mapped. */
+	bool isOpen() const;
+
+	/** \brief Gets pointer to the mapped file contents. */
+	const unsigned char* getData() const;
+
+	/** \brief Gets size of the mapped file, in bytes. */
+	size_t getSize() const;
+
+private:
+	const unsigned char* _data = nullptr; //! Mapped file contents
+	size_t _size = 0; //! Size of the mapped file in bytes
+#ifdef _WIN32
+	void* _fileHandle = nullptr; //! Windows file handle
+	void* _mappingHandle = nullptr; //! Windows file mapping handle
+#endif
+};
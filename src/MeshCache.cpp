@@ -0,0 +1,83 @@
+// STL
+#include <functional>
+
+// Project
+#include "MeshCache.h"
+
+namespace static_meshes_3D {
+
+	bool CylinderKey::operator==(const CylinderKey& other) const
+	{
+		return radius == other.radius
+			&& numSlices == other.numSlices
+			&& height == other.height
+			&& withPositions == other.withPositions
+			&& withTextureCoordinates == other.withTextureCoordinates
+			&& withNormals == other.withNormals;
+	}
+
+	size_t CylinderKeyHash::operator()(const CylinderKey& key) const
+	{
+		// Combine hashes of all members, same way as boost::hash_combine does
+		size_t seed = 0;
+		const auto combine = [&seed](size_t value) {
+			seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		};
+
+		combine(std::hash<float>()(key.radius));
+		combine(std::hash<int>()(key.numSlices));
+		combine(std::hash<float>()(key.height));
+		combine((key.withPositions ? 1 : 0) | (key.withTextureCoordinates ? 2 : 0) | (key.withNormals ? 4 : 0));
+		return seed;
+	}
+
+	std::shared_ptr<const IndexedCylinder> MeshCache::getCylinder(float radius, int numSlices, float height,
+		bool withPositions, bool withTextureCoordinates, bool withNormals)
+	{
+		const CylinderKey key{ radius, numSlices, height, withPositions, withTextureCoordinates, withNormals };
+
+		auto it = _cylinders.find(key);
+		if (it != _cylinders.end())
+		{
+			if (auto cylinder = it->second.lock())
+			{
+				_stats.hits++;
+				return cylinder;
+			}
+		}
+
+		// Not cached (or already released), build the mesh and upload it to the GPU
+		_stats.misses++;
+		const auto cylinder = new IndexedCylinder(radius, numSlices, height, withPositions, withTextureCoordinates, withNormals);
+		_stats.numMeshes++;
+		_stats.gpuBytes += cylinder->getGPUByteSize();
+
+		std::shared_ptr<const IndexedCylinder> result(cylinder, [this, key](const IndexedCylinder* mesh) {
+			_stats.numMeshes--;
+			_stats.gpuBytes -= mesh->getGPUByteSize();
+
+			// Only forget the entry if nobody has rebuilt the mesh in the meantime
+			auto entry = _cylinders.find(key);
+			if (entry != _cylinders.end() && entry->second.expired()) {
+				_cylinders.erase(entry);
+			}
+
+			delete mesh;
+		});
+
+		_cylinders[key] = result;
+		return result;
+	}
+
+	const MeshCacheStats& MeshCache::getStats() const
+	{
+		return _stats;
+	}
+
+	void MeshCache::printStats(std::ostream& os) const
+	{
+		os << "Mesh cache: " << _stats.hits << " hits, " << _stats.misses << " misses, "
+			<< _stats.numMeshes << " meshes holding " << _stats.gpuBytes << " bytes on the GPU" << std::endl;
+	}
+
+} // namespace static_meshes_3D
@@ -0,0 +1,75 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+
+// Project
+#include "IndexedCylinder.h"
+
+namespace static_meshes_3D {
+
+	/**
+	* Key identifying one cached cylinder - its shape parameters and vertex attribute flags.
+	*/
+	struct CylinderKey
+	{
+		float radius;
+		int numSlices;
+		float height;
+		bool withPositions;
+		bool withTextureCoordinates;
+		bool withNormals;
+
+		bool operator==(const CylinderKey& other) const;
+	};
+
+	struct CylinderKeyHash
+	{
+		size_t operator()(const CylinderKey& key) const;
+	};
+
+	/**
+	* Counters of the mesh cache, so that we can confirm meshes are not rebuilt every frame.
+	*/
+	struct MeshCacheStats
+	{
+		uint64_t hits = 0; //!< How many requests were served by an already built mesh
+		uint64_t misses = 0; //!< How many requests had to build (and upload) a new mesh
+		size_t numMeshes = 0; //!< Number of meshes currently alive
+		size_t gpuBytes = 0; //!< Bytes of vertex data currently held on the GPU
+	};
+
+	/**
+	* Registry of static meshes keyed by their shape parameters. Meshes are built and uploaded
+	* to the GPU on first request only, every other request with the same parameters gets
+	* a shared handle to the same mesh. Mesh is deleted when the last handle goes away,
+	* so the cache must outlive all handles it gave out (and the OpenGL context must outlive both).
+	*/
+	class MeshCache
+	{
+	public:
+		MeshCache() = default;
+		MeshCache(const MeshCache&) = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+
+		/** \brief  Gets shared cylinder with given parameters, builds it if it does not exist yet.
+		*   \return Reference counted handle to the GPU-resident cylinder.
+		*/
+		std::shared_ptr<const IndexedCylinder> getCylinder(float radius, int numSlices, float height,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+
+		/** \brief  Gets cache counters (hits, misses, GPU bytes held). */
+		const MeshCacheStats& getStats() const;
+
+		/** \brief  Prints cache counters in a human readable form. */
+		void printStats(std::ostream& os) const;
+
+	private:
+		std::unordered_map<CylinderKey, std::weak_ptr<const IndexedCylinder>, CylinderKeyHash> _cylinders;
+		MeshCacheStats _stats;
+	};
+
+} // namespace static_meshes_3D
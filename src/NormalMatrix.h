@@ -0,0 +1,30 @@
+#pragma once
+
+// STL
+#include <cmath>
+
+// GLM
+#include <glm/glm.hpp>
+
+/** \brief Computes matrix transforming normals of given model matrix (inverse transpose of its upper 3x3).
+*   Rotations with uniform scale, which is what most objects have, take a fast path without any inverse:
+*   the inverse transpose of s * R is R / s, i.e. the matrix itself divided by s squared.
+*/
+inline glm::mat3 computeNormalMatrix(const glm::mat4& model)
+{
+	const glm::mat3 linear(model);
+	const auto xx = glm::dot(linear[0], linear[0]);
+	const auto yy = glm::dot(linear[1], linear[1]);
+	const auto zz = glm::dot(linear[2], linear[2]);
+	const auto xy = glm::dot(linear[0], linear[1]);
+	const auto xz = glm::dot(linear[0], linear[2]);
+	const auto yz = glm::dot(linear[1], linear[2]);
+
+	// Columns orthogonal and of the same length means rotation with uniform scale
+	const auto tolerance = 1e-5f * xx;
+	if (xx > 0.0f && std::abs(xx - yy) <= tolerance && std::abs(xx - zz) <= tolerance
+		&& std::abs(xy) <= tolerance && std::abs(xz) <= tolerance && std::abs(yz) <= tolerance) {
+		return linear / xx;
+	}
+	return glm::transpose(glm::inverse(linear));
+}
@@ -0,0 +1,53 @@
+// STL
+#include <iostream>
+
+// Project
+#include "GLExtensions.h"
+#include "ParallelShaderCompile.h"
+
+namespace {
+
+	typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+} // namespace
+
+bool ParallelShaderCompile::_isAvailable = false;
+
+bool ParallelShaderCompile::initialize(GLADloadproc load)
+{
+	// Both extensions share the enum, they differ only in suffix of the thread count function
+	PFNGLMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads = nullptr;
+	if (hasGLExtension("GL_KHR_parallel_shader_compile")) {
+		maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSPROC>(load("glMaxShaderCompilerThreadsKHR"));
+	}
+	else if (hasGLExtension("GL_ARB_parallel_shader_compile")) {
+		maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSPROC>(load("glMaxShaderCompilerThreadsARB"));
+	}
+
+	_isAvailable = maxShaderCompilerThreads != nullptr;
+	if (!_isAvailable)
+	{
+		std::cout << "GL_KHR_parallel_shader_compile is not available, shaders are compiled as the driver sees fit" << std::endl;
+		return false;
+	}
+
+	// 0xFFFFFFFF lets the driver use as many threads as it likes
+	maxShaderCompilerThreads(0xFFFFFFFFu);
+	return true;
+}
+
+bool ParallelShaderCompile::isAvailable()
+{
+	return _isAvailable;
+}
+
+bool ParallelShaderCompile::isProgramComplete(GLuint program)
+{
+	if (!_isAvailable) {
+		return true;
+	}
+
+	GLint isComplete = GL_TRUE;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &isComplete);
+	return isComplete != GL_FALSE;
+}
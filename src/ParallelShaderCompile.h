@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/*
+  GL_KHR_parallel_shader_compile (or its ARB twin) - the driver compiles and links on its own threads,
+  glCompileShader/glLinkProgram return right away and GL_COMPLETION_STATUS_KHR tells, if the result is
+  ready without blocking. Without the extension, the status is always reported ready and the first
+  status query simply waits for the driver (which may still compile in the background on its own).
+*/
+class ParallelShaderCompile
+{
+public:
+	/** \brief Looks for the extension and lets the driver pick number of compiler threads, call right after glad has been loaded.
+	*   \param load Loader given to glad, glad loads no extensions, so the entry point is loaded here
+	*   \return True if compilation runs in parallel, false otherwise.
+	*/
+	static bool initialize(GLADloadproc load);
+
+	/** \brief Checks, if the extension is available. */
+	static bool isAvailable();
+
+	/** \brief Checks without blocking, if linking of given program has finished. */
+	static bool isProgramComplete(GLuint program);
+
+private:
+	static bool _isAvailable; //! Flag telling, if completion status can be queried
+};
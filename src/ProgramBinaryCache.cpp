@@ -0,0 +1,235 @@
+// STL
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// Project
+#include "GLExtensions.h"
+#include "ProgramBinaryCache.h"
+
+namespace {
+
+	const char PROGRAM_BINARY_MAGIC[4] = { 'P', 'B', 'I', 'N' };
+	const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	const uint64_t FNV_PRIME = 1099511628211ull;
+
+	/** Header of a cached binary file, followed by the binary itself. */
+	struct ProgramBinaryHeader
+	{
+		char magic[4];
+		uint32_t format; // Binary format reported by glGetProgramBinary
+		uint32_t length; // Length of the binary in bytes
+		uint32_t reserved;
+		uint64_t key; // Key the binary has been stored under, guards against hash-named file mix-ups
+	};
+
+	/** Continues FNV-1a hash with given data, terminated by a zero byte so that fields can't run into each other. */
+	uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+	{
+		const auto bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+		hash ^= 0;
+		return hash * FNV_PRIME;
+	}
+
+	uint64_t fnv1a(uint64_t hash, const std::string& text)
+	{
+		return fnv1a(hash, text.data(), text.size());
+	}
+
+	/** Random tag chosen once per process. */
+	const std::string& getProcessTag()
+	{
+		static const std::string tag = []() {
+			std::random_device device;
+			const auto value = (uint64_t(device()) << 32) ^ uint64_t(device())
+				^ uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+			std::ostringstream stream;
+			stream << std::hex << value;
+			return stream.str();
+		}();
+		return tag;
+	}
+
+	std::string getString(GLenum name)
+	{
+		const auto value = reinterpret_cast<const char*>(glGetString(name));
+		return value != nullptr ? value : "";
+	}
+
+} // namespace
+
+bool ProgramBinaryCache::initialize(const std::string& directory, GLADloadproc load)
+{
+	_isAvailable = false;
+
+	// Functions are core since 4.1, glad loads no extensions, so with GL_ARB_get_program_binary on older context we load them ourselves
+	auto isSupported = GLAD_GL_VERSION_4_1 != 0;
+	if (!isSupported && hasGLExtension("GL_ARB_get_program_binary"))
+	{
+		glad_glGetProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+		glad_glProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(load("glProgramBinary"));
+		glad_glProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+		isSupported = glad_glGetProgramBinary != nullptr && glad_glProgramBinary != nullptr && glad_glProgramParameteri != nullptr;
+	}
+
+	// Drivers may support the functions, but no binary format at all (e.g. some Mesa drivers)
+	GLint numFormats = 0;
+	if (isSupported) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	}
+	if (numFormats <= 0)
+	{
+		std::cout << "Program binaries are not supported, shaders are always compiled from source" << std::endl;
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		std::cerr << "Could not create shader cache directory " << directory << " (" << error.message() << ")!" << std::endl;
+		return false;
+	}
+
+	_directory = directory;
+	_driverHash = FNV_OFFSET_BASIS;
+	for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+		_driverHash = fnv1a(_driverHash, getString(name));
+	}
+	_isAvailable = true;
+	return true;
+}
+
+bool ProgramBinaryCache::isAvailable() const
+{
+	return _isAvailable;
+}
+
+uint64_t ProgramBinaryCache::makeKey(const std::string& vertexCode, const std::string& fragmentCode, const std::string& geometryCode) const
+{
+	auto hash = _driverHash;
+	hash = fnv1a(hash, vertexCode);
+	hash = fnv1a(hash, fragmentCode);
+	return fnv1a(hash, geometryCode);
+}
+
+bool ProgramBinaryCache::load(GLuint program, uint64_t key)
+{
+	if (!_isAvailable) {
+		return false;
+	}
+
+	std::ifstream file(getPath(key), std::ios::binary);
+	ProgramBinaryHeader header;
+	if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+		|| memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(PROGRAM_BINARY_MAGIC)) != 0 || header.key != key)
+	{
+		_misses++;
+		return false;
+	}
+
+	// the length comes from the file, a corrupted one must not allocate more than the file holds
+	const auto binaryStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	const auto remaining = file.tellg() - binaryStart;
+	file.seekg(binaryStart);
+	if (binaryStart < 0 || remaining < std::streamoff(header.length))
+	{
+		_misses++;
+		return false;
+	}
+
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), binary.size()))
+	{
+		_misses++;
+		return false;
+	}
+
+	glProgramBinary(program, header.format, binary.data(), GLsizei(binary.size()));
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		_rejected++;
+		return false;
+	}
+
+	_hits++;
+	return true;
+}
+
+void ProgramBinaryCache::prepareForLink(GLuint program) const
+{
+	if (_isAvailable) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+}
+
+void ProgramBinaryCache::store(GLuint program, uint64_t key)
+{
+	GLint linked = GL_FALSE, length = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!_isAvailable || !linked || length <= 0) {
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	GLsizei writtenLength = 0;
+	glGetProgramBinary(program, length, &writtenLength, &format, binary.data());
+
+	ProgramBinaryHeader header;
+	memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(PROGRAM_BINARY_MAGIC));
+	header.format = format;
+	header.length = uint32_t(writtenLength);
+	header.reserved = 0;
+	header.key = key;
+
+	// Written aside and renamed, so that processes starting at the same time never read a half-written binary,
+	// the temporary name is unique to the process, so that processes storing the same binary do not write into one file
+	const auto path = getPath(key);
+	const auto temporaryPath = path + "." + getProcessTag() + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), writtenLength);
+		if (!file.good())
+		{
+			std::cerr << "Could not write program binary " << temporaryPath << "!" << std::endl;
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error) {
+		std::filesystem::remove(temporaryPath, error);
+	}
+}
+
+void ProgramBinaryCache::printStats(std::ostream& os) const
+{
+	os << "Program binary cache: " << _hits << " hits, " << _misses << " misses, " << _rejected << " rejected by driver" << std::endl;
+}
+
+std::string ProgramBinaryCache::getPath(uint64_t key) const
+{
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+	std::string name(16, '0');
+	for (int i = 15; i >= 0; i--, key >>= 4) {
+		name[i] = HEX_DIGITS[key & 0xF];
+	}
+	return (std::filesystem::path(_directory) / (name + ".bin")).string();
+}
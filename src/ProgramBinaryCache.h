@@ -0,0 +1,57 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include <glad/glad.h>
+
+/**
+  On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary), so that restarted
+  processes skip compiling and linking GLSL. Binaries are keyed by FNV-1a hash of the final sources
+  (defines included) and of the driver identification, as a binary is valid only for the driver that made it.
+  Driver may still reject a binary (e.g. after an update keeping the version string), the caller then
+  compiles from source and stores the fresh binary.
+*/
+class ProgramBinaryCache
+{
+public:
+	/** \brief Checks driver support and creates the cache directory.
+	*   \param directory Directory to keep binaries in
+	*   \param load Loader given to glad, used to get GL_ARB_get_program_binary entry points on contexts older than 4.1
+	*   \return True if the cache can be used, false otherwise.
+	*/
+	bool initialize(const std::string& directory, GLADloadproc load);
+
+	/** \brief Checks, if the cache has been initialized successfully. */
+	bool isAvailable() const;
+
+	/** \brief Makes key of a program from its final sources (geometry code may be empty). */
+	uint64_t makeKey(const std::string& vertexCode, const std::string& fragmentCode, const std::string& geometryCode) const;
+
+	/** \brief Loads cached binary of given key into the program.
+	*   \return True if the program is linked from the binary, false if there is none or the driver rejected it.
+	*/
+	bool load(GLuint program, uint64_t key);
+
+	/** \brief Marks program to be linked as one whose binary will be retrieved (call before glLinkProgram). */
+	void prepareForLink(GLuint program) const;
+
+	/** \brief Stores binary of the linked program under given key (does nothing if it did not link). */
+	void store(GLuint program, uint64_t key);
+
+	/** \brief Prints hits, misses and rejected binaries in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+private:
+	std::string _directory; // Directory with cached binaries
+	uint64_t _driverHash = 0; // Hash of vendor, renderer and version strings
+	bool _isAvailable = false;
+
+	uint64_t _hits = 0; // Programs linked from binary
+	uint64_t _misses = 0; // Programs not found in the cache
+	uint64_t _rejected = 0; // Binaries the driver refused
+
+	std::string getPath(uint64_t key) const;
+};
@@ -0,0 +1,233 @@
+// STL
+#include <algorithm>
+
+// Project
+#include "GLDebug.h"
+#include "RenderQueue.h"
+
+namespace {
+
+	// Layout of the sort key, from the most significant bit:
+	// opaque:      0 | program (12) | texture unit 0 (16) | VAO (12) | depth front to back (23)
+	// transparent: 1 | depth back to front (23) | program (12) | texture unit 0 (16) | VAO (12)
+	// GL names wider than their field just share a bucket, which costs some sorting quality, never correctness.
+	const int DEPTH_BITS = 23;
+	const int VAO_BITS = 12;
+	const int TEXTURE_BITS = 16;
+	const int PROGRAM_BITS = 12;
+
+	uint64_t bits(uint64_t value, int numBits)
+	{
+		return value & ((uint64_t(1) << numBits) - 1);
+	}
+
+} // namespace
+
+void RenderQueue::setCamera(const glm::vec3& position, const glm::vec3& front, float farPlane)
+{
+	_cameraPosition = position;
+	_cameraFront = front;
+	_farPlane = farPlane;
+}
+
+void RenderQueue::submit(const RenderPacket& packet)
+{
+	_sortItems.push_back({ makeSortKey(packet), uint32_t(_packets.size()) });
+	_packets.push_back(packet);
+}
+
+void RenderQueue::flush()
+{
+	GL_DEBUG_GROUP("Render queue");
+
+	_stats.numPackets += int(_packets.size());
+
+	// What would submission order cost (with and without skipping redundant binds)
+	BoundState unsortedState;
+	RenderQueueStats unsortedStats;
+	for (const auto& packet : _packets)
+	{
+		unsortedState.apply(packet, false, unsortedStats);
+
+		_stats.naiveStateChanges += 2; // program and VAO
+		for (auto unit = 0; unit < RenderPacket::MAX_TEXTURES; unit++) {
+			_stats.naiveStateChanges += (packet.textures[unit] != 0 ? 1 : 0) + (packet.samplers[unit] != 0 ? 1 : 0);
+		}
+	}
+	_stats.unsortedStateChanges += unsortedStats.programChanges + unsortedStats.textureChanges + unsortedStats.samplerChanges
+		+ unsortedStats.vaoChanges;
+
+	// Packet index breaks ties, so that the order is stable between frames
+	std::sort(_sortItems.begin(), _sortItems.end(), [](const SortItem& a, const SortItem& b) {
+		return a.key != b.key ? a.key < b.key : a.packetIndex < b.packetIndex;
+	});
+
+	BoundState state;
+	auto primitiveRestart = false;
+	GLuint primitiveRestartIndex = 0;
+	for (const auto& item : _sortItems)
+	{
+		const auto& packet = _packets[item.packetIndex];
+		state.apply(packet, true, _stats);
+
+		if (packet.hasModel)
+		{
+			packet.shader->setMat4(state.model, packet.model);
+			if (state.normalMatrix.isValid()) {
+				packet.shader->setMat3(state.normalMatrix, packet.normalMatrix);
+			}
+		}
+		if (packet.numLights >= 0 && state.objectLightCount.isValid())
+		{
+			packet.shader->setInt(state.objectLightCount, packet.numLights);
+			if (packet.numLights > 0) {
+				packet.shader->setIntArray(state.objectLights, packet.lights, packet.numLights);
+			}
+		}
+		if (state.textureRects.isValid())
+		{
+			packet.shader->setVec4Array(state.textureRects, packet.textureRects, RenderPacket::MAX_TEXTURES);
+			packet.shader->setFloatArray(state.textureLayers, packet.textureLayers, RenderPacket::MAX_TEXTURES);
+		}
+
+		if (packet.draw.primitiveRestart != primitiveRestart)
+		{
+			primitiveRestart = packet.draw.primitiveRestart;
+			if (primitiveRestart) {
+				glEnable(GL_PRIMITIVE_RESTART);
+			}
+			else {
+				glDisable(GL_PRIMITIVE_RESTART);
+			}
+		}
+		if (primitiveRestart && packet.draw.primitiveRestartIndex != primitiveRestartIndex)
+		{
+			primitiveRestartIndex = packet.draw.primitiveRestartIndex;
+			glPrimitiveRestartIndex(primitiveRestartIndex);
+		}
+
+		packet.draw.execute();
+		_stats.drawCalls++;
+		_stats.triangles += packet.draw.getNumTriangles();
+	}
+
+	if (primitiveRestart) {
+		glDisable(GL_PRIMITIVE_RESTART);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	// units get their texture parameters back for whoever binds textures outside of the queue
+	for (auto unit = 0; unit < RenderPacket::MAX_TEXTURES; unit++)
+	{
+		if (state.samplers[unit] != 0) {
+			glBindSampler(GLuint(unit), 0);
+		}
+	}
+
+	_stats.stateChanges = _stats.programChanges + _stats.textureChanges + _stats.samplerChanges + _stats.vaoChanges;
+
+	_packets.clear();
+	_sortItems.clear();
+}
+
+void RenderQueue::resetStats()
+{
+	_stats = RenderQueueStats();
+}
+
+const RenderQueueStats& RenderQueue::getStats() const
+{
+	return _stats;
+}
+
+void RenderQueue::printStats(std::ostream& os) const
+{
+	os << "Render queue: " << _stats.numPackets << " packets, " << _stats.drawCalls << " draw calls, "
+		<< _stats.triangles << " triangles, " << _stats.stateChanges << " state changes ("
+		<< _stats.programChanges << " programs, " << _stats.textureChanges << " textures, " << _stats.samplerChanges << " samplers, "
+		<< _stats.vaoChanges << " VAOs), "
+		<< _stats.unsortedStateChanges << " in submission order, " << _stats.naiveStateChanges << " when binding everything per draw, "
+		<< _stats.savedStateChanges() << " saved" << std::endl;
+}
+
+void RenderQueue::BoundState::apply(const RenderPacket& packet, bool bind, RenderQueueStats& stats)
+{
+	if (firstPacket || packet.shader->ID != program)
+	{
+		program = packet.shader->ID;
+		stats.programChanges++;
+		if (bind)
+		{
+			packet.shader->use();
+			model = packet.shader->getUniform("model");
+			normalMatrix = packet.shader->getUniform("normalMatrix");
+			objectLightCount = packet.shader->getUniform("objectLightCount");
+			objectLights = packet.shader->getUniform("objectLights");
+			textureRects = packet.shader->getUniform("textureRects");
+			textureLayers = packet.shader->getUniform("textureLayers");
+		}
+	}
+
+	for (auto unit = 0; unit < RenderPacket::MAX_TEXTURES; unit++)
+	{
+		if (packet.textures[unit] != 0 && (firstPacket || packet.textures[unit] != textures[unit]))
+		{
+			textures[unit] = packet.textures[unit];
+			stats.textureChanges++;
+			if (bind)
+			{
+				glActiveTexture(GL_TEXTURE0 + unit);
+				glBindTexture(packet.textureTarget, textures[unit]);
+			}
+		}
+		// samplers are shared by many textures, so they change far less often (units start without one)
+		if (packet.textures[unit] != 0 && packet.samplers[unit] != samplers[unit])
+		{
+			samplers[unit] = packet.samplers[unit];
+			stats.samplerChanges++;
+			if (bind) {
+				glBindSampler(GLuint(unit), samplers[unit]);
+			}
+		}
+	}
+
+	if (firstPacket || packet.vao != vao)
+	{
+		vao = packet.vao;
+		stats.vaoChanges++;
+		if (bind) {
+			glBindVertexArray(vao);
+		}
+	}
+
+	firstPacket = false;
+}
+
+uint64_t RenderQueue::makeSortKey(const RenderPacket& packet) const
+{
+	// Quantized distance along the view direction, packets without model matrix go first
+	auto depth = 0.0f;
+	if (packet.hasModel) {
+		depth = glm::dot(glm::vec3(packet.model[3]) - _cameraPosition, _cameraFront) / _farPlane;
+	}
+	depth = std::min(std::max(depth, 0.0f), 1.0f);
+	const auto maxDepth = (uint64_t(1) << DEPTH_BITS) - 1;
+	const auto depthBits = uint64_t(depth * maxDepth);
+
+	const auto program = bits(packet.shader->ID, PROGRAM_BITS);
+	const auto texture = bits(packet.textures[0], TEXTURE_BITS);
+	const auto vao = bits(packet.vao, VAO_BITS);
+
+	if (!packet.transparent)
+	{
+		return (program << (TEXTURE_BITS + VAO_BITS + DEPTH_BITS))
+			| (texture << (VAO_BITS + DEPTH_BITS))
+			| (vao << DEPTH_BITS)
+			| depthBits;
+	}
+
+	return (uint64_t(1) << 63)
+		| ((maxDepth - depthBits) << (PROGRAM_BITS + TEXTURE_BITS + VAO_BITS))
+		| (program << (TEXTURE_BITS + VAO_BITS))
+		| (texture << VAO_BITS)
+		| vao;
+}
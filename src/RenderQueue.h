@@ -0,0 +1,121 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "DrawCommand.h"
+#include "shader.h"
+#include "UniformBlocks.h"
+
+/**
+  One draw submitted to the render queue, together with all the state it needs.
+*/
+struct RenderPacket
+{
+	static const int MAX_TEXTURES = 2; //! Number of texture units a packet can bind (0 and 1)
+
+	Shader* shader = nullptr; //! Program to draw with, its per-frame uniforms must be set already
+	GLuint vao = 0; //! VAO to draw from
+	GLuint textures[MAX_TEXTURES] = {}; //! 2D textures bound to texture units 0..MAX_TEXTURES-1 (0 = leave unit as it is)
+	GLuint samplers[MAX_TEXTURES] = {}; //! Sampler objects of the textures (0 = sample with parameters of the texture)
+	GLenum textureTarget = GL_TEXTURE_2D; //! Target all textures of the packet are bound to (GL_TEXTURE_2D_ARRAY for TextureArrays)
+	glm::vec4 textureRects[MAX_TEXTURES] = { glm::vec4(1.0f, 1.0f, 0.0f, 0.0f), glm::vec4(1.0f, 1.0f, 0.0f, 0.0f) }; //! Rectangles of the textures in their layers, uploaded to "textureRects" uniform (TEXTURE_ARRAYS permutations only)
+	float textureLayers[MAX_TEXTURES] = {}; //! Layers of the textures, uploaded to "textureLayers" uniform
+	glm::mat4 model = glm::mat4(1.0f); //! Model matrix, uploaded to "model" uniform
+	glm::mat3 normalMatrix = glm::mat3(1.0f); //! Normal matrix of the model (see computeNormalMatrix), uploaded to "normalMatrix" uniform
+	bool hasModel = true; //! False for draws without "model" uniform (e.g. instanced draws)
+	int lights[MAX_LIGHTS_PER_OBJECT] = {}; //! Lights touching the object (see LightCulling), uploaded to "objectLights" uniform
+	int numLights = -1; //! Lights in the list, uploaded to "objectLightCount" uniform (-1 for draws without light list)
+	bool transparent = false; //! Transparent packets are drawn after opaque ones, back to front
+	DrawCommand draw; //! The draw call itself
+};
+
+/**
+  Statistics of all flushes since the last reset (one frame may flush several passes).
+*/
+struct RenderQueueStats
+{
+	int numPackets = 0; //! Number of packets drawn
+	int programChanges = 0; //! Programs actually bound
+	int textureChanges = 0; //! Textures actually bound
+	int samplerChanges = 0; //! Sampler objects actually bound
+	int vaoChanges = 0; //! VAOs actually bound
+	int stateChanges = 0; //! Sum of the four above
+	int unsortedStateChanges = 0; //! State changes in submission order, redundant ones skipped
+	int naiveStateChanges = 0; //! State changes if every packet bound all its state (hand-written draws)
+	int drawCalls = 0; //! Draw calls issued
+	uint64_t triangles = 0; //! Triangles drawn, over all instances
+
+	/** \brief Gets how many state changes the queue saved compared to binding everything per draw. */
+	int savedStateChanges() const { return naiveStateChanges - stateChanges; }
+};
+
+/**
+  Collects draws during a frame and issues them sorted by a 64-bit key, so that program, texture
+  and VAO switches are minimized and opaque objects are drawn front to back (for early-Z).
+*/
+class RenderQueue
+{
+public:
+	/** \brief Sets camera used to compute depth of packets submitted from now on. */
+	void setCamera(const glm::vec3& position, const glm::vec3& front, float farPlane);
+
+	/** \brief Adds a draw to the queue. */
+	void submit(const RenderPacket& packet);
+
+	/** \brief Sorts and issues all submitted draws, then empties the queue. */
+	void flush();
+
+	/** \brief Starts collecting statistics anew, called at the start of every frame. */
+	void resetStats();
+
+	/** \brief Gets statistics of the flushes since the last reset. */
+	const RenderQueueStats& getStats() const;
+
+	/** \brief Prints statistics of the flushes since the last reset in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+private:
+	struct SortItem
+	{
+		uint64_t key;
+		uint32_t packetIndex;
+	};
+
+	/** \brief Bound state while issuing packets, used to skip redundant binds. */
+	struct BoundState
+	{
+		GLuint program = 0;
+		GLuint textures[RenderPacket::MAX_TEXTURES] = {};
+		GLuint samplers[RenderPacket::MAX_TEXTURES] = {};
+		GLuint vao = 0;
+		UniformHandle model; //! "model" uniform of the bound program (looked up on program change only)
+		UniformHandle normalMatrix; //! "normalMatrix" uniform of the bound program, invalid for programs not lighting anything
+		UniformHandle objectLightCount; //! "objectLightCount" uniform of the bound program, valid for LIGHT_CULLING permutations only
+		UniformHandle objectLights; //! "objectLights" uniform of the bound program
+		UniformHandle textureRects; //! "textureRects" uniform of the bound program, valid for non-instanced TEXTURE_ARRAYS permutations only
+		UniformHandle textureLayers; //! "textureLayers" uniform of the bound program
+		bool firstPacket = true;
+
+		/** \brief Switches to the state of the packet and counts the changes into stats.
+		*   \param bind True to also issue the OpenGL binds, false to only count them
+		*/
+		void apply(const RenderPacket& packet, bool bind, RenderQueueStats& stats);
+	};
+
+	std::vector<RenderPacket> _packets;
+	std::vector<SortItem> _sortItems;
+	RenderQueueStats _stats;
+
+	glm::vec3 _cameraPosition = glm::vec3(0.0f);
+	glm::vec3 _cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+	float _farPlane = 100.0f;
+
+	uint64_t makeSortKey(const RenderPacket& packet) const;
+};
@@ -0,0 +1,548 @@
+// STL
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+// GLM
+#include <glm/gtc/matrix_transform.hpp>
+
+// Project
+#include "Scene.h"
+
+namespace {
+
+	const char SCENE_FILE_MAGIC[4] = { 'S', 'C', 'N', 'B' };
+	const uint32_t SCENE_FILE_VERSION = 3;
+
+	/** Header of the baked scene, followed by the record arrays and string table at given offsets. */
+	struct SceneFileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t numMeshes;
+		uint32_t numMaterials;
+		uint32_t numObjects;
+		uint32_t numLights;
+		uint32_t stringsSize;
+		uint32_t meshesOffset;
+		uint32_t materialsOffset;
+		uint32_t objectsOffset;
+		uint32_t lightsOffset;
+		uint32_t stringsOffset;
+	};
+
+	/** Reads vec3 from the stream, returns false if it's not there. */
+	bool readVec3(std::istream& is, glm::vec3& result)
+	{
+		return static_cast<bool>(is >> result.x >> result.y >> result.z);
+	}
+
+	// Planes and spheres are grids of detail x detail vertices indexed by 16-bit indices, cylinders need at least a triangle
+	const int32_t MIN_GRID_DETAIL = 2;
+	const int32_t MAX_GRID_DETAIL = 256;
+	const int32_t MIN_CYLINDER_DETAIL = 3;
+
+	/** Checks, if the mesh record has a known type with detail its generator can build. */
+	bool isValidMesh(const SceneMeshRecord& mesh)
+	{
+		switch (mesh.type)
+		{
+		case SCENE_MESH_CUBE:
+			return true;
+		case SCENE_MESH_PLANE:
+		case SCENE_MESH_SPHERE:
+			return mesh.detail >= MIN_GRID_DETAIL && mesh.detail <= MAX_GRID_DETAIL;
+		case SCENE_MESH_CYLINDER:
+			return mesh.detail >= MIN_CYLINDER_DETAIL;
+		default:
+			return false;
+		}
+	}
+
+	/** Reads optional integer from the stream, returns default value if it's not there. */
+	int readOptionalInt(std::istream& is, int defaultValue)
+	{
+		int result;
+		return is >> result ? result : defaultValue;
+	}
+
+	/** Reads light properties (position, ambient, diffuse, specular, attenuation) until the end of the line. */
+	bool readLightProperties(std::istream& is, SceneLightRecord& light)
+	{
+		std::string property;
+		while (is >> property)
+		{
+			auto valid = false;
+			if (property == "position") {
+				valid = readVec3(is, light.position);
+			}
+			else if (property == "ambient") {
+				valid = readVec3(is, light.ambient);
+			}
+			else if (property == "diffuse") {
+				valid = readVec3(is, light.diffuse);
+			}
+			else if (property == "specular") {
+				valid = readVec3(is, light.specular);
+			}
+			else if (property == "attenuation") {
+				valid = static_cast<bool>(is >> light.constant >> light.linear >> light.quadratic);
+			}
+
+			if (!valid) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Applies transform operations (translate, scale, rotate, identity) until the end of the line,
+	*   "dynamic" is accepted among them when object flags are given.
+	*/
+	bool readTransform(std::istream& is, glm::mat4& model, uint32_t* objectFlags = nullptr)
+	{
+		std::string operation;
+		while (is >> operation)
+		{
+			if (operation == "dynamic" && objectFlags != nullptr) {
+				*objectFlags |= SCENE_OBJECT_DYNAMIC;
+			}
+			else if (operation == "translate")
+			{
+				glm::vec3 offset;
+				if (!readVec3(is, offset)) {
+					return false;
+				}
+				model = glm::translate(model, offset);
+			}
+			else if (operation == "scale")
+			{
+				// Either one uniform factor or three factors
+				std::vector<float> factors;
+				float factor;
+				while (factors.size() < 3 && is >> factor) {
+					factors.push_back(factor);
+				}
+				is.clear();
+				if (factors.size() == 1) {
+					model = glm::scale(model, glm::vec3(factors[0]));
+				}
+				else if (factors.size() == 3) {
+					model = glm::scale(model, glm::vec3(factors[0], factors[1], factors[2]));
+				}
+				else {
+					return false;
+				}
+			}
+			else if (operation == "rotate")
+			{
+				float degrees;
+				glm::vec3 axis;
+				if (!(is >> degrees) || !readVec3(is, axis)) {
+					return false;
+				}
+				model = glm::rotate(model, glm::radians(degrees), axis);
+			}
+			else if (operation == "identity")
+			{
+				// Restarts from identity matrix multiplied by given factor (including w)
+				float factor;
+				if (!(is >> factor)) {
+					return false;
+				}
+				model = glm::mat4(factor);
+			}
+			else {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template<typename T>
+	bool checkSection(const SceneFileHeader& header, size_t fileSize, uint32_t offset, uint32_t count)
+	{
+		return offset % 4 == 0 && offset >= sizeof(header) && uint64_t(offset) + uint64_t(count) * sizeof(T) <= fileSize;
+	}
+
+} // namespace
+
+const uint32_t Scene::NO_STRING = 0xFFFFFFFF;
+
+bool Scene::loadText(const std::string& path)
+{
+	clear();
+
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		std::cerr << "Could not open scene file " << path << "!" << std::endl;
+		return false;
+	}
+
+	std::unordered_map<std::string, uint32_t> meshNames, materialNames;
+	std::string line;
+	auto lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		const auto commentStart = line.find('#');
+		if (commentStart != std::string::npos) {
+			line.erase(commentStart);
+		}
+
+		std::istringstream is(line);
+		std::string keyword;
+		if (!(is >> keyword)) {
+			continue;
+		}
+
+		auto valid = true;
+		if (keyword == "mesh")
+		{
+			std::string name, type;
+			SceneMeshRecord mesh = { SCENE_MESH_CUBE, 0, 0.0f, 0.0f };
+			valid = static_cast<bool>(is >> name >> type);
+			if (valid && type == "cube") {
+				mesh.type = SCENE_MESH_CUBE;
+			}
+			else if (valid && type == "plane")
+			{
+				mesh.type = SCENE_MESH_PLANE;
+				mesh.detail = readOptionalInt(is, 10);
+			}
+			else if (valid && type == "sphere")
+			{
+				mesh.type = SCENE_MESH_SPHERE;
+				mesh.detail = readOptionalInt(is, 20);
+			}
+			else if (valid && type == "cylinder")
+			{
+				mesh.type = SCENE_MESH_CYLINDER;
+				valid = static_cast<bool>(is >> mesh.radius >> mesh.detail >> mesh.height);
+			}
+			else {
+				valid = false;
+			}
+			valid = valid && isValidMesh(mesh);
+
+			if (valid)
+			{
+				meshNames[name] = uint32_t(_ownedMeshes.size());
+				_ownedMeshes.push_back(mesh);
+			}
+		}
+		else if (keyword == "material")
+		{
+			std::string name, texture;
+			valid = static_cast<bool>(is >> name >> texture);
+			if (valid)
+			{
+				auto addString = [this](const std::string& value)
+				{
+					const auto offset = uint32_t(_ownedStrings.size());
+					_ownedStrings.insert(_ownedStrings.end(), value.begin(), value.end());
+					_ownedStrings.push_back('\0');
+					return offset;
+				};
+
+				SceneMaterialRecord material = { NO_STRING, NO_STRING, 0 };
+				if (texture == "unlit") {
+					material.flags |= SCENE_MATERIAL_UNLIT;
+				}
+				else
+				{
+					material.diffuseTexture = addString(texture);
+
+					// Optional specular map
+					std::string property, specularTexture;
+					if (is >> property)
+					{
+						valid = property == "specular" && static_cast<bool>(is >> specularTexture);
+						if (valid) {
+							material.specularTexture = addString(specularTexture);
+						}
+					}
+				}
+
+				if (valid)
+				{
+					materialNames[name] = uint32_t(_ownedMaterials.size());
+					_ownedMaterials.push_back(material);
+				}
+			}
+		}
+		else if (keyword == "object")
+		{
+			std::string meshName, materialName;
+			valid = static_cast<bool>(is >> meshName >> materialName);
+			if (valid && (meshNames.count(meshName) == 0 || materialNames.count(materialName) == 0))
+			{
+				std::cerr << "Scene " << path << ":" << lineNumber << ": unknown mesh or material!" << std::endl;
+				clear();
+				return false;
+			}
+
+			SceneObjectRecord object;
+			object.flags = 0;
+			object.model = glm::mat4(1.0f);
+			if (valid && readTransform(is, object.model, &object.flags))
+			{
+				object.mesh = meshNames[meshName];
+				object.material = materialNames[materialName];
+				_ownedObjects.push_back(object);
+			}
+			else {
+				valid = false;
+			}
+		}
+		else if (keyword == "light")
+		{
+			SceneLightRecord light = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f, 0.0f, 0.0f };
+			valid = readLightProperties(is, light);
+			if (valid) {
+				_ownedLights.push_back(light);
+			}
+		}
+		else if (keyword == "lightgrid")
+		{
+			// Evenly spaced lights filling a box, e.g. a venue ceiling
+			int countX, countY, countZ;
+			glm::vec3 from, to;
+			std::string fromKeyword, toKeyword;
+			SceneLightRecord light = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f, 0.0f, 0.0f };
+			valid = static_cast<bool>(is >> countX >> countY >> countZ >> fromKeyword) && fromKeyword == "from" && readVec3(is, from)
+				&& static_cast<bool>(is >> toKeyword) && toKeyword == "to" && readVec3(is, to)
+				&& countX > 0 && countY > 0 && countZ > 0 && readLightProperties(is, light);
+			if (valid)
+			{
+				// A single light on an axis sits at its "from" coordinate
+				const auto step = (to - from) / glm::vec3(float(std::max(countX - 1, 1)), float(std::max(countY - 1, 1)), float(std::max(countZ - 1, 1)));
+				for (auto z = 0; z < countZ; z++)
+				{
+					for (auto y = 0; y < countY; y++)
+					{
+						for (auto x = 0; x < countX; x++)
+						{
+							light.position = from + step * glm::vec3(float(x), float(y), float(z));
+							_ownedLights.push_back(light);
+						}
+					}
+				}
+			}
+		}
+		else {
+			valid = false;
+		}
+
+		if (!valid)
+		{
+			std::cerr << "Scene " << path << ":" << lineNumber << ": could not parse '" << line << "'!" << std::endl;
+			clear();
+			return false;
+		}
+	}
+
+	useOwnedData();
+	return true;
+}
+
+bool Scene::loadBinary(const std::string& path)
+{
+	clear();
+
+	if (!_mappedFile.open(path)) {
+		return false;
+	}
+
+	const auto data = _mappedFile.getData();
+	const auto size = _mappedFile.getSize();
+	SceneFileHeader header;
+	if (size < sizeof(header))
+	{
+		std::cerr << "Baked scene " << path << " is truncated!" << std::endl;
+		clear();
+		return false;
+	}
+
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, SCENE_FILE_MAGIC, sizeof(SCENE_FILE_MAGIC)) != 0 || header.version != SCENE_FILE_VERSION)
+	{
+		std::cerr << "File " << path << " is not a baked scene of version " << SCENE_FILE_VERSION << "!" << std::endl;
+		clear();
+		return false;
+	}
+
+	if (!checkSection<SceneMeshRecord>(header, size, header.meshesOffset, header.numMeshes)
+		|| !checkSection<SceneMaterialRecord>(header, size, header.materialsOffset, header.numMaterials)
+		|| !checkSection<SceneObjectRecord>(header, size, header.objectsOffset, header.numObjects)
+		|| !checkSection<SceneLightRecord>(header, size, header.lightsOffset, header.numLights)
+		|| !checkSection<char>(header, size, header.stringsOffset, header.stringsSize))
+	{
+		std::cerr << "Baked scene " << path << " is corrupted!" << std::endl;
+		clear();
+		return false;
+	}
+
+	// Records are used right from the mapping, there is nothing to parse
+	_meshes = reinterpret_cast<const SceneMeshRecord*>(data + header.meshesOffset);
+	_materials = reinterpret_cast<const SceneMaterialRecord*>(data + header.materialsOffset);
+	_objects = reinterpret_cast<const SceneObjectRecord*>(data + header.objectsOffset);
+	_lights = reinterpret_cast<const SceneLightRecord*>(data + header.lightsOffset);
+	_strings = reinterpret_cast<const char*>(data + header.stringsOffset);
+	_numMeshes = header.numMeshes;
+	_numMaterials = header.numMaterials;
+	_numObjects = header.numObjects;
+	_numLights = header.numLights;
+	_stringsSize = header.stringsSize;
+
+	// Indices and mesh parameters are validated once here, so that users of the records can trust them
+	for (uint32_t i = 0; i < _numMeshes; i++)
+	{
+		if (!isValidMesh(_meshes[i]))
+		{
+			std::cerr << "Baked scene " << path << " has invalid mesh " << i << "!" << std::endl;
+			clear();
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < _numObjects; i++)
+	{
+		if (_objects[i].mesh >= _numMeshes || _objects[i].material >= _numMaterials)
+		{
+			std::cerr << "Baked scene " << path << " references missing mesh or material!" << std::endl;
+			clear();
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < _numMaterials; i++)
+	{
+		for (const auto texture : { _materials[i].diffuseTexture, _materials[i].specularTexture })
+		{
+			if (texture != NO_STRING && (texture >= _stringsSize || memchr(_strings + texture, '\0', _stringsSize - texture) == nullptr))
+			{
+				std::cerr << "Baked scene " << path << " has invalid texture path!" << std::endl;
+				clear();
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Scene::load(const std::string& path)
+{
+	const std::string binaryExtension = ".sceneb";
+	if (path.size() >= binaryExtension.size() && path.compare(path.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0) {
+		return loadBinary(path);
+	}
+
+	return loadText(path);
+}
+
+bool Scene::saveBinary(const std::string& path) const
+{
+	SceneFileHeader header;
+	memcpy(header.magic, SCENE_FILE_MAGIC, sizeof(SCENE_FILE_MAGIC));
+	header.version = SCENE_FILE_VERSION;
+	header.numMeshes = _numMeshes;
+	header.numMaterials = _numMaterials;
+	header.numObjects = _numObjects;
+	header.numLights = _numLights;
+	header.stringsSize = _stringsSize;
+	header.meshesOffset = sizeof(header);
+	header.materialsOffset = header.meshesOffset + _numMeshes * sizeof(SceneMeshRecord);
+	header.objectsOffset = header.materialsOffset + _numMaterials * sizeof(SceneMaterialRecord);
+	header.lightsOffset = header.objectsOffset + _numObjects * sizeof(SceneObjectRecord);
+	header.stringsOffset = header.lightsOffset + _numLights * sizeof(SceneLightRecord);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Could not write baked scene " << path << "!" << std::endl;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(_meshes), _numMeshes * sizeof(SceneMeshRecord));
+	file.write(reinterpret_cast<const char*>(_materials), _numMaterials * sizeof(SceneMaterialRecord));
+	file.write(reinterpret_cast<const char*>(_objects), _numObjects * sizeof(SceneObjectRecord));
+	file.write(reinterpret_cast<const char*>(_lights), _numLights * sizeof(SceneLightRecord));
+	file.write(_strings, _stringsSize);
+	return file.good();
+}
+
+uint32_t Scene::getNumMeshes() const
+{
+	return _numMeshes;
+}
+
+const SceneMeshRecord& Scene::getMesh(uint32_t index) const
+{
+	return _meshes[index];
+}
+
+uint32_t Scene::getNumMaterials() const
+{
+	return _numMaterials;
+}
+
+const SceneMaterialRecord& Scene::getMaterial(uint32_t index) const
+{
+	return _materials[index];
+}
+
+uint32_t Scene::getNumObjects() const
+{
+	return _numObjects;
+}
+
+const SceneObjectRecord& Scene::getObject(uint32_t index) const
+{
+	return _objects[index];
+}
+
+uint32_t Scene::getNumLights() const
+{
+	return _numLights;
+}
+
+const SceneLightRecord& Scene::getLight(uint32_t index) const
+{
+	return _lights[index];
+}
+
+const char* Scene::getString(uint32_t offset) const
+{
+	return offset == NO_STRING ? "" : _strings + offset;
+}
+
+void Scene::clear()
+{
+	_ownedMeshes.clear();
+	_ownedMaterials.clear();
+	_ownedObjects.clear();
+	_ownedLights.clear();
+	_ownedStrings.clear();
+	_mappedFile.close();
+	useOwnedData();
+}
+
+void Scene::useOwnedData()
+{
+	_meshes = _ownedMeshes.data();
+	_materials = _ownedMaterials.data();
+	_objects = _ownedObjects.data();
+	_lights = _ownedLights.data();
+	_strings = _ownedStrings.data();
+	_numMeshes = uint32_t(_ownedMeshes.size());
+	_numMaterials = uint32_t(_ownedMaterials.size());
+	_numObjects = uint32_t(_ownedObjects.size());
+	_numLights = uint32_t(_ownedLights.size());
+	_stringsSize = uint32_t(_ownedStrings.size());
+}
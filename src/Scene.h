@@ -0,0 +1,136 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "MappedFile.h"
+
+/*
+  Scene description - meshes, materials, objects and point lights. Scenes are authored in a text
+  format (see res/scenes/default.scene) and can be baked into a binary form, whose records are
+  used in place from a memory-mapped file. All records are plain data with 4-byte alignment,
+  so that the binary form is just the arrays below written one after another.
+*/
+
+/** Kind of built-in mesh. */
+enum SceneMeshType : uint32_t
+{
+	SCENE_MESH_CUBE = 0,
+	SCENE_MESH_PLANE = 1,
+	SCENE_MESH_SPHERE = 2,
+	SCENE_MESH_CYLINDER = 3
+};
+
+/** Flags of scene materials. */
+enum SceneMaterialFlags : uint32_t
+{
+	SCENE_MATERIAL_UNLIT = 1 //!< Drawn without lighting (e.g. light bulbs)
+};
+
+/** Flags of scene objects. */
+enum SceneObjectFlags : uint32_t
+{
+	SCENE_OBJECT_DYNAMIC = 1 //!< Moves at runtime (turns around its own y axis), kept out of cached shadow maps
+};
+
+struct SceneMeshRecord
+{
+	uint32_t type; //!< One of SceneMeshType
+	int32_t detail; //!< Plane dimensions, sphere tesselation or cylinder slices
+	float radius; //!< Cylinder radius
+	float height; //!< Cylinder height
+};
+
+struct SceneMaterialRecord
+{
+	uint32_t diffuseTexture; //!< Offset of diffuse texture path in string table, NO_STRING if there is none
+	uint32_t specularTexture; //!< Offset of specular map path in string table, NO_STRING if there is none
+	uint32_t flags; //!< Combination of SceneMaterialFlags
+};
+
+struct SceneObjectRecord
+{
+	uint32_t mesh; //!< Index of mesh record
+	uint32_t material; //!< Index of material record
+	uint32_t flags; //!< Combination of SceneObjectFlags
+	glm::mat4 model; //!< World transformation (initial one for dynamic objects)
+};
+
+struct SceneLightRecord
+{
+	glm::vec3 position;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	float constant;
+	float linear;
+	float quadratic;
+};
+
+class Scene
+{
+public:
+	static const uint32_t NO_STRING; //!< String offset meaning "no string"
+
+	/** \brief Loads scene from the text format.
+	*   \return True if the scene has been loaded, false otherwise.
+	*/
+	bool loadText(const std::string& path);
+
+	/** \brief Loads baked scene by memory-mapping it, records are used in place.
+	*   \return True if the scene has been loaded, false otherwise.
+	*/
+	bool loadBinary(const std::string& path);
+
+	/** \brief Loads scene in the format given by file extension (.sceneb is binary, anything else text). */
+	bool load(const std::string& path);
+
+	/** \brief Bakes this scene into the binary form.
+	*   \return True if the file has been written, false otherwise.
+	*/
+	bool saveBinary(const std::string& path) const;
+
+	uint32_t getNumMeshes() const;
+	const SceneMeshRecord& getMesh(uint32_t index) const;
+
+	uint32_t getNumMaterials() const;
+	const SceneMaterialRecord& getMaterial(uint32_t index) const;
+
+	uint32_t getNumObjects() const;
+	const SceneObjectRecord& getObject(uint32_t index) const;
+
+	uint32_t getNumLights() const;
+	const SceneLightRecord& getLight(uint32_t index) const;
+
+	/** \brief Gets string from the string table, or empty string for NO_STRING. */
+	const char* getString(uint32_t offset) const;
+
+private:
+	// Data loaded from text are owned here, data loaded from binary live in the mapped file
+	std::vector<SceneMeshRecord> _ownedMeshes;
+	std::vector<SceneMaterialRecord> _ownedMaterials;
+	std::vector<SceneObjectRecord> _ownedObjects;
+	std::vector<SceneLightRecord> _ownedLights;
+	std::vector<char> _ownedStrings;
+	MappedFile _mappedFile;
+
+	const SceneMeshRecord* _meshes = nullptr;
+	const SceneMaterialRecord* _materials = nullptr;
+	const SceneObjectRecord* _objects = nullptr;
+	const SceneLightRecord* _lights = nullptr;
+	const char* _strings = nullptr;
+	uint32_t _numMeshes = 0;
+	uint32_t _numMaterials = 0;
+	uint32_t _numObjects = 0;
+	uint32_t _numLights = 0;
+	uint32_t _stringsSize = 0;
+
+	void clear();
+	void useOwnedData();
+};
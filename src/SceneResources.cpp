@@ -0,0 +1,554 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+
+// GLM
+#include <glm/gtc/matrix_transform.hpp>
+
+// Project
+#include "GLDebug.h"
+#include "NormalMatrix.h"
+#include "SceneResources.h"
+#include "ShapeGenerator.h"
+#include "UniformBlocks.h"
+
+namespace {
+
+	// offset variables for plane, sphere
+	const unsigned int NUM_FLOATS_PER_VERTICE = 9;
+	const unsigned int VERTEX_BYTE_SIZE = NUM_FLOATS_PER_VERTICE * sizeof(float);
+
+	// How fast dynamic objects turn around their own y axis, in degrees per second
+	const float DYNAMIC_OBJECT_SPIN = 30.0f;
+
+	// World space box around a transformed local box - its center is transformed, its half extents projected onto world axes
+	void transformBounds(const glm::mat4& model, const glm::vec3& localMin, const glm::vec3& localMax, glm::vec3& worldMin, glm::vec3& worldMax)
+	{
+		const auto center = glm::vec3(model * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+		const auto extent = (localMax - localMin) * 0.5f;
+		glm::vec3 worldExtent;
+		for (auto axis = 0; axis < 3; axis++) {
+			worldExtent[axis] = std::abs(model[0][axis]) * extent.x + std::abs(model[1][axis]) * extent.y + std::abs(model[2][axis]) * extent.z;
+		}
+		worldMin = center - worldExtent;
+		worldMax = center + worldExtent;
+	}
+
+	// Shadow casters only write depth, with the given program and without textures or lights
+	void submitShadowCaster(RenderQueue& renderQueue, Shader* shader, RenderPacket packet)
+	{
+		packet.shader = shader;
+		packet.textures[0] = packet.textures[1] = 0;
+		packet.numLights = -1;
+		renderQueue.submit(packet);
+	}
+
+} // namespace
+
+SceneResources::~SceneResources()
+{
+	deleteResources();
+}
+
+bool SceneResources::create(const Scene& scene, static_meshes_3D::MeshCache& meshCache, TextureCache& textureCache, const SceneShaders& shaders)
+{
+	deleteResources();
+
+	// Lighting permutation of a material - only as many lights as the scene has, specular only with specular map,
+	// G-buffer permutations have no lights at all
+	auto getLightingShader = [&](uint32_t material, bool instanced, bool gbuffer)
+	{
+		LightingPermutation permutation;
+		permutation.numPointLights = shaders.clusteredLighting || gbuffer ? 0 : int(std::min(scene.getNumLights(), MAX_POINT_LIGHTS));
+		permutation.clustered = shaders.clusteredLighting && !gbuffer;
+		permutation.hasSpecularMap = scene.getMaterial(material).specularTexture != Scene::NO_STRING;
+		permutation.instanced = instanced;
+		permutation.gbuffer = gbuffer;
+		permutation.lightCulling = shaders.lightCulling != nullptr && !permutation.clustered && !gbuffer;
+		permutation.shadows = shaders.shadows && !permutation.clustered && !gbuffer;
+		permutation.textureArrays = shaders.textureArrays;
+		return shaders.lighting->request(permutation);
+	};
+	auto getGBufferShader = [&](uint32_t material, bool instanced)
+	{
+		return shaders.deferredShading ? getLightingShader(material, instanced, true) : nullptr;
+	};
+
+	// Programs are submitted first, so that the driver compiles them while meshes and textures load
+	for (uint32_t i = 0; i < scene.getNumObjects(); i++)
+	{
+		const auto& object = scene.getObject(i);
+		if ((scene.getMaterial(object.material).flags & SCENE_MATERIAL_UNLIT) != 0) {
+			continue;
+		}
+		getLightingShader(object.material, false, false);
+		getGBufferShader(object.material, false);
+		if (scene.getMesh(object.mesh).type == SCENE_MESH_CYLINDER)
+		{
+			getLightingShader(object.material, true, false);
+			getGBufferShader(object.material, true);
+		}
+	}
+
+	// Meshes
+	for (uint32_t i = 0; i < scene.getNumMeshes(); i++)
+	{
+		const auto& record = scene.getMesh(i);
+		GpuMesh mesh;
+		switch (record.type)
+		{
+		case SCENE_MESH_CUBE:
+			mesh = createCube();
+			break;
+		case SCENE_MESH_PLANE:
+			mesh = createShape(ShapeGenerator::makePlane(record.detail), "Plane");
+			break;
+		case SCENE_MESH_SPHERE:
+			mesh = createShape(ShapeGenerator::makeSphere(record.detail), "Sphere");
+			break;
+		case SCENE_MESH_CYLINDER:
+			mesh.cylinder = meshCache.getCylinder(record.radius, record.detail, record.height);
+			mesh.vao = mesh.cylinder->getVAO();
+			mesh.draw = mesh.cylinder->getDrawCommand();
+			mesh.boundsMin = glm::vec3(-record.radius, -record.height / 2.0f, -record.radius);
+			mesh.boundsMax = glm::vec3(record.radius, record.height / 2.0f, record.radius);
+			break;
+		default:
+			std::cerr << "Unknown scene mesh type " << record.type << "!" << std::endl;
+			deleteResources();
+			return false;
+		}
+		_meshes.push_back(std::move(mesh));
+	}
+
+	// Textures, materials referring to the same image share it
+	if (shaders.textureArrays)
+	{
+		// every image once, in order of first use
+		std::vector<std::string> paths;
+		std::map<uint32_t, size_t> imageIndices;
+		auto addImage = [&](uint32_t path)
+		{
+			if (path != Scene::NO_STRING && imageIndices.emplace(path, paths.size()).second) {
+				paths.push_back(scene.getString(path));
+			}
+		};
+		for (uint32_t i = 0; i < scene.getNumMaterials(); i++)
+		{
+			addImage(scene.getMaterial(i).diffuseTexture);
+			addImage(scene.getMaterial(i).specularTexture);
+		}
+		_textureArrays.build(paths);
+
+		for (uint32_t i = 0; i < scene.getNumMaterials(); i++)
+		{
+			const auto& material = scene.getMaterial(i);
+			MaterialTextures textures;
+			if (material.diffuseTexture != Scene::NO_STRING) {
+				textures.diffuseSlot = &_textureArrays.getSlot(imageIndices[material.diffuseTexture]);
+			}
+			if (material.specularTexture != Scene::NO_STRING) {
+				textures.specularSlot = &_textureArrays.getSlot(imageIndices[material.specularTexture]);
+			}
+			textures.arraySampler = _textureArrays.getSampler();
+			_materialTextures.push_back(textures);
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < scene.getNumMaterials(); i++)
+		{
+			const auto& material = scene.getMaterial(i);
+			MaterialTextures textures;
+			if (material.diffuseTexture != Scene::NO_STRING) {
+				textures.diffuse = textureCache.getTexture(scene.getString(material.diffuseTexture));
+			}
+			if (material.specularTexture != Scene::NO_STRING) {
+				textures.specular = textureCache.getTexture(scene.getString(material.specularTexture));
+			}
+			_materialTextures.push_back(textures);
+		}
+	}
+
+	// With texture arrays, materials whose maps are in the same arrays share batches (and programs),
+	// the first material of each such group stands for all of them
+	std::vector<uint32_t> batchMaterials(scene.getNumMaterials());
+	std::map<std::tuple<GLuint, GLuint, bool>, uint32_t> arrayMaterials;
+	for (uint32_t i = 0; i < scene.getNumMaterials(); i++)
+	{
+		const auto& textures = _materialTextures[i];
+		batchMaterials[i] = i;
+		if (shaders.textureArrays)
+		{
+			const auto arrays = std::make_tuple(textures.diffuseSlot != nullptr ? textures.diffuseSlot->array : 0u,
+				textures.specularSlot != nullptr ? textures.specularSlot->array : 0u, textures.specularSlot != nullptr);
+			batchMaterials[i] = arrayMaterials.emplace(arrays, i).first->second;
+		}
+	}
+
+	// Draws - lit cylinders are also gathered into instanced batches by slice count and material (or texture arrays),
+	// lit objects get lists of the lights touching them, batches of the lights touching any of their instances
+	const auto cullLights = shaders.lightCulling != nullptr && !shaders.clusteredLighting;
+	std::map<std::pair<int, uint32_t>, size_t> batchIndices;
+	std::vector<std::pair<glm::vec3, glm::vec3>> batchBounds;
+	for (uint32_t i = 0; i < scene.getNumObjects(); i++)
+	{
+		const auto& object = scene.getObject(i);
+		const auto& meshRecord = scene.getMesh(object.mesh);
+		const auto& mesh = _meshes[object.mesh];
+		const auto unlit = (scene.getMaterial(object.material).flags & SCENE_MATERIAL_UNLIT) != 0;
+		const auto dynamic = (object.flags & SCENE_OBJECT_DYNAMIC) != 0;
+
+		ScenePacket scenePacket;
+		scenePacket.lit = !unlit;
+		scenePacket.dynamic = dynamic;
+		scenePacket.gbufferShader = unlit ? nullptr : getGBufferShader(object.material, false);
+		auto& packet = scenePacket.packet;
+		packet.shader = unlit ? shaders.unlit : getLightingShader(object.material, false, false);
+		packet.vao = mesh.vao;
+		_materialTextures[object.material].apply(packet);
+		packet.model = object.model;
+		packet.normalMatrix = computeNormalMatrix(object.model);
+		packet.draw = mesh.draw;
+
+		// dynamic objects are bounded in every orientation they turn into
+		glm::vec3 boundsMin, boundsMax;
+		if (dynamic)
+		{
+			const auto reach = std::max(glm::length(mesh.boundsMin), glm::length(mesh.boundsMax));
+			transformBounds(object.model, glm::vec3(-reach), glm::vec3(reach), boundsMin, boundsMax);
+		}
+		else {
+			transformBounds(object.model, mesh.boundsMin, mesh.boundsMax, boundsMin, boundsMax);
+		}
+		if (cullLights && !unlit) {
+			packet.numLights = shaders.lightCulling->findLights(boundsMin, boundsMax, packet.lights);
+		}
+		if (packet.textures[0] != 0 || packet.textures[1] != 0) {
+			_textureUses.push_back({ { packet.textures[0], packet.textures[1] }, (boundsMin + boundsMax) * 0.5f, glm::length(boundsMax - boundsMin) * 0.5f });
+		}
+
+		if (meshRecord.type != SCENE_MESH_CYLINDER || unlit || dynamic)
+		{
+			if (dynamic)
+			{
+				if (!unlit) {
+					_dynamicShadowCasters.push_back(_dynamicObjects.size());
+				}
+				_dynamicObjects.push_back({ _packets.size(), object.model, boundsMin, boundsMax });
+			}
+			_packets.push_back(scenePacket);
+			continue;
+		}
+		_cylinderPackets.push_back(scenePacket);
+
+		const auto batchKey = std::make_pair(int(meshRecord.detail), batchMaterials[object.material]);
+		auto batchIt = batchIndices.find(batchKey);
+		if (batchIt == batchIndices.end())
+		{
+			batchIt = batchIndices.emplace(batchKey, _cylinderBatches.size()).first;
+			_cylinderBatches.emplace_back(new static_meshes_3D::CylinderBatch(meshCache.getCylinder(1, meshRecord.detail, 1)));
+			batchBounds.emplace_back(boundsMin, boundsMax);
+		}
+		_cylinderBatches[batchIt->second]->addInstance(object.model, meshRecord.radius, meshRecord.height,
+			_materialTextures[object.material].getInstanceTextures());
+		auto& bounds = batchBounds[batchIt->second];
+		bounds.first = glm::min(bounds.first, boundsMin);
+		bounds.second = glm::max(bounds.second, boundsMax);
+	}
+
+	for (const auto& batchIndex : batchIndices)
+	{
+		auto& batch = *_cylinderBatches[batchIndex.second];
+		batch.uploadInstances();
+
+		ScenePacket scenePacket;
+		scenePacket.gbufferShader = getGBufferShader(batchIndex.first.second, true);
+		auto& packet = scenePacket.packet;
+		packet.shader = getLightingShader(batchIndex.first.second, true, false);
+		packet.vao = batch.getVAO();
+		_materialTextures[batchIndex.first.second].apply(packet);
+		packet.hasModel = false;
+		packet.draw = batch.getDrawCommand();
+		if (cullLights)
+		{
+			const auto& bounds = batchBounds[batchIndex.second];
+			packet.numLights = shaders.lightCulling->findLights(bounds.first, bounds.second, packet.lights);
+		}
+		_instancedCylinderPackets.push_back(scenePacket);
+	}
+
+	return true;
+}
+
+void SceneResources::submit(RenderQueue& renderQueue, bool instancedCylinders, ScenePass pass) const
+{
+	auto submitPackets = [&](const std::vector<ScenePacket>& scenePackets)
+	{
+		for (const auto& scenePacket : scenePackets)
+		{
+			if (pass == SCENE_PASS_FORWARD || (pass == SCENE_PASS_UNLIT && !scenePacket.lit)) {
+				renderQueue.submit(scenePacket.packet);
+			}
+			else if (pass == SCENE_PASS_GBUFFER && scenePacket.gbufferShader != nullptr)
+			{
+				auto packet = scenePacket.packet;
+				packet.shader = scenePacket.gbufferShader;
+				renderQueue.submit(packet);
+			}
+		}
+	};
+	submitPackets(_packets);
+	submitPackets(instancedCylinders ? _instancedCylinderPackets : _cylinderPackets);
+}
+
+void SceneResources::submitShadowCasters(RenderQueue& renderQueue, Shader* shader) const
+{
+	// lit objects one by one, light bulbs would only shadow their own light
+	auto submitPackets = [&](const std::vector<ScenePacket>& scenePackets)
+	{
+		for (const auto& scenePacket : scenePackets)
+		{
+			if (scenePacket.lit && !scenePacket.dynamic) {
+				submitShadowCaster(renderQueue, shader, scenePacket.packet);
+			}
+		}
+	};
+	submitPackets(_packets);
+	submitPackets(_cylinderPackets);
+}
+
+size_t SceneResources::getNumDynamicShadowCasters() const
+{
+	return _dynamicShadowCasters.size();
+}
+
+void SceneResources::getDynamicShadowCasterBounds(size_t caster, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+	const auto& object = _dynamicObjects[_dynamicShadowCasters[caster]];
+	boundsMin = object.boundsMin;
+	boundsMax = object.boundsMax;
+}
+
+void SceneResources::submitDynamicShadowCaster(RenderQueue& renderQueue, Shader* shader, size_t caster) const
+{
+	submitShadowCaster(renderQueue, shader, _packets[_dynamicObjects[_dynamicShadowCasters[caster]].packetIndex].packet);
+}
+
+void SceneResources::update(float time)
+{
+	for (const auto& object : _dynamicObjects)
+	{
+		auto& packet = _packets[object.packetIndex].packet;
+		packet.model = glm::rotate(object.model, glm::radians(DYNAMIC_OBJECT_SPIN * time), glm::vec3(0.0f, 1.0f, 0.0f));
+		packet.normalMatrix = computeNormalMatrix(packet.model);
+	}
+}
+
+void SceneResources::deleteResources()
+{
+	_packets.clear();
+	_cylinderPackets.clear();
+	_instancedCylinderPackets.clear();
+	_dynamicObjects.clear();
+	_dynamicShadowCasters.clear();
+	_textureUses.clear();
+	_cylinderBatches.clear();
+
+	for (auto& mesh : _meshes)
+	{
+		// Cylinders are owned by the mesh cache, just release them
+		if (mesh.cylinder == nullptr)
+		{
+			glDeleteVertexArrays(1, &mesh.vao);
+			glDeleteBuffers(1, &mesh.vbo);
+		}
+	}
+	_meshes.clear();
+
+	// Textures are owned by the texture cache, just release them, texture arrays are our own
+	_materialTextures.clear();
+	_textureArrays.deleteResources();
+}
+
+void SceneResources::requestTextureLevels(TextureStreamer& streamer, const glm::vec3& cameraPosition, const glm::mat4& projection, int viewportHeight) const
+{
+	// pixels per world unit at distance 1 (perspective) or anywhere (orthographic)
+	const auto pixelsPerUnit = projection[1][1] * float(viewportHeight) * 0.5f;
+	const auto perspective = projection[2][3] != 0.0f;
+	for (const auto& use : _textureUses)
+	{
+		// the camera inside the sphere sees it at least as large as from its surface
+		const auto distance = perspective ? std::max(glm::length(use.center - cameraPosition), use.radius) : 1.0f;
+		const auto screenSize = 2.0f * use.radius * pixelsPerUnit / distance;
+		for (const auto texture : use.textures)
+		{
+			if (texture != 0) {
+				streamer.request(texture, screenSize);
+			}
+		}
+	}
+}
+
+const TextureArrays& SceneResources::getTextureArrays() const
+{
+	return _textureArrays;
+}
+
+void SceneResources::MaterialTextures::apply(RenderPacket& packet) const
+{
+	if (diffuse)
+	{
+		packet.textures[0] = diffuse->id;
+		packet.samplers[0] = diffuse->sampler;
+	}
+	if (specular)
+	{
+		packet.textures[1] = specular->id;
+		packet.samplers[1] = specular->sampler;
+	}
+
+	const TextureSlot* slots[RenderPacket::MAX_TEXTURES] = { diffuseSlot, specularSlot };
+	for (auto unit = 0; unit < RenderPacket::MAX_TEXTURES; unit++)
+	{
+		if (slots[unit] == nullptr) {
+			continue;
+		}
+		packet.textureTarget = GL_TEXTURE_2D_ARRAY;
+		packet.textures[unit] = slots[unit]->array;
+		packet.samplers[unit] = arraySampler;
+		packet.textureRects[unit] = slots[unit]->rect;
+		packet.textureLayers[unit] = slots[unit]->layer;
+	}
+}
+
+static_meshes_3D::InstanceTextures SceneResources::MaterialTextures::getInstanceTextures() const
+{
+	static_meshes_3D::InstanceTextures result;
+	if (diffuseSlot != nullptr)
+	{
+		result.diffuseRect = diffuseSlot->rect;
+		result.layers.x = diffuseSlot->layer;
+	}
+	if (specularSlot != nullptr)
+	{
+		result.specularRect = specularSlot->rect;
+		result.layers.y = specularSlot->layer;
+	}
+	return result;
+}
+
+SceneResources::GpuMesh SceneResources::createCube()
+{
+	const float vertices[] = {
+		// positions          // normals           // texture coords
+		//Front Face
+		-1.8f,	0.0f, -0.70f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, 
+		 1.8f,  0.0f, -0.70f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		 1.8f, 0.45f, -0.70f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f, 
+		 1.8f, 0.45f, -0.70f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-1.8f, 0.45f, -0.70f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-1.8f,  0.0f, -0.70f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f, 
+		// Back face
+		-1.8f,  0.0f,  0.70f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		 1.8f,  0.0f,  0.70f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		 1.8f, 0.45f,  0.70f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		 1.8f, 0.45f,  0.70f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-1.8f, 0.45f,  0.70f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-1.8f,  0.0f,  0.70f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+	
+		-1.8f, 0.45f,  0.70f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-1.8f, 0.45f, -0.70f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-1.8f,  0.0f, -0.70f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-1.8f,  0.0f, -0.70f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-1.8f,  0.0f,  0.70f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-1.8f, 0.45f,  0.70f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+	
+		 1.8f, 0.45f,  0.70f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		 1.8f, 0.45f, -0.70f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		 1.8f,  0.0f, -0.70f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		 1.8f,  0.0f, -0.70f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		 1.8f,  0.0f,  0.70f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		 1.8f, 0.45f,  0.70f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+	
+		-1.8f, -0.0f, -0.70f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		 1.8f, -0.0f, -0.70f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		 1.8f, -0.0f,  0.70f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		 1.8f, -0.0f,  0.70f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-1.8f, -0.0f,  0.70f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-1.8f, -0.0f, -0.70f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+	
+		-1.8f, 0.45f, -0.70f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		 1.8f, 0.45f, -0.70f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		 1.8f, 0.45f,  0.70f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		 1.8f, 0.45f,  0.70f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-1.8f, 0.45f,  0.70f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-1.8f, 0.45f, -0.70f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	GpuMesh mesh;
+	glGenVertexArrays(1, &mesh.vao);
+	glGenBuffers(1, &mesh.vbo);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	glBindVertexArray(mesh.vao);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	GL_LABEL(GL_VERTEX_ARRAY, mesh.vao, "Cube");
+
+	mesh.draw = DrawCommand::arrays(GL_TRIANGLES, 0, 36);
+	mesh.boundsMin = mesh.boundsMax = glm::vec3(vertices[0], vertices[1], vertices[2]);
+	for (size_t i = 0; i < sizeof(vertices) / sizeof(float); i += 8)
+	{
+		const glm::vec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+		mesh.boundsMin = glm::min(mesh.boundsMin, position);
+		mesh.boundsMax = glm::max(mesh.boundsMax, position);
+	}
+	return mesh;
+}
+
+SceneResources::GpuMesh SceneResources::createShape(const ShapeData& shape, const char* name)
+{
+	// vertices and indices share one buffer, indices go right after vertices
+	GpuMesh mesh;
+	glGenVertexArrays(1, &mesh.vao);
+	glGenBuffers(1, &mesh.vbo);
+
+	glBindVertexArray(mesh.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+	glBufferData(GL_ARRAY_BUFFER, shape.vertexBufferSize() + shape.indexBufferSize(), 0, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, shape.vertexBufferSize(), shape.vertices);
+	glBufferSubData(GL_ARRAY_BUFFER, shape.vertexBufferSize(), shape.indexBufferSize(), shape.indices);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 3));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 6));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbo);
+	GL_LABEL(GL_VERTEX_ARRAY, mesh.vao, name);
+
+	mesh.draw = DrawCommand::elements(GL_TRIANGLES, shape.numIndices, GL_UNSIGNED_SHORT, shape.vertexBufferSize());
+	for (GLuint i = 0; i < shape.numVertices; i++)
+	{
+		mesh.boundsMin = i == 0 ? shape.vertices[i].position : glm::min(mesh.boundsMin, shape.vertices[i].position);
+		mesh.boundsMax = i == 0 ? shape.vertices[i].position : glm::max(mesh.boundsMax, shape.vertices[i].position);
+	}
+
+	// data are on the GPU now
+	ShapeData uploaded = shape;
+	uploaded.cleanup();
+	return mesh;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+// STL
+#include <memory>
+#include <vector>
+
+// Project
+#include "CylinderBatch.h"
+#include "LightCulling.h"
+#include "LightingShaders.h"
+#include "MeshCache.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "TextureArrays.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+
+struct ShapeData;
+
+/**
+  Programs the scene objects are drawn with.
+*/
+struct SceneShaders
+{
+	LightingShaderCache* lighting = nullptr; //! Lit objects, each gets the cheapest permutation for its material
+	Shader* unlit = nullptr; //! Unlit objects (light bulbs)
+	bool clusteredLighting = false; //! Lit objects take their lights from ClusteredLighting (any number of them)
+	LightCulling* lightCulling = nullptr; //! Lit objects evaluate only the lights touching their bounds (null to evaluate all), unused with clustered lighting
+	bool shadows = false; //! Lit objects are shadowed by the first lights of the scene (ShadowMaps), unused with clustered lighting
+	bool deferredShading = false; //! G-buffer programs of lit objects are prepared too, so that DeferredShading can be switched on at runtime
+	bool textureArrays = false; //! Material textures are packed into TextureArrays instead of loaded through the texture cache,
+	                            //! so that objects of different materials share textures (and instanced batches)
+};
+
+/** Objects SceneResources::submit draws, and with which programs. */
+enum ScenePass
+{
+	SCENE_PASS_FORWARD = 0, //! All objects, lit ones with their lighting programs
+	SCENE_PASS_GBUFFER = 1, //! Lit objects only, with their G-buffer programs (SceneShaders::deferredShading must be set)
+	SCENE_PASS_UNLIT = 2 //! Unlit objects only, drawn forward on top of the deferred lighting
+};
+
+/**
+  GPU resources of a scene - meshes, textures, instanced cylinder batches and recorded draws.
+  All of them are built in bulk from the scene records, every frame only submits the recorded draws.
+*/
+class SceneResources
+{
+public:
+	SceneResources() = default;
+	~SceneResources();
+
+	SceneResources(const SceneResources&) = delete;
+	SceneResources& operator=(const SceneResources&) = delete;
+
+	/** \brief Builds GPU resources of the scene and records its draws.
+	*   \return True if everything has been created, false otherwise.
+	*/
+	bool create(const Scene& scene, static_meshes_3D::MeshCache& meshCache, TextureCache& textureCache, const SceneShaders& shaders);
+
+	/** \brief Submits draws of the scene objects belonging to given pass.
+	*   \param instancedCylinders True to draw lit cylinders with instanced batches, false to draw one mesh per cylinder
+	*/
+	void submit(RenderQueue& renderQueue, bool instancedCylinders, ScenePass pass = SCENE_PASS_FORWARD) const;
+
+	/** \brief Submits one draw per lit static object with given program (and no textures), for rendering shadow maps. */
+	void submitShadowCasters(RenderQueue& renderQueue, Shader* shader) const;
+
+	/** \brief Gets number of lit dynamic objects, the ones casting shadows that move. */
+	size_t getNumDynamicShadowCasters() const;
+
+	/** \brief Gets world space box of given lit dynamic object, in every orientation it turns into. */
+	void getDynamicShadowCasterBounds(size_t caster, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+
+	/** \brief Submits draw of given lit dynamic object with given program (and no textures), for rendering shadow maps. */
+	void submitDynamicShadowCaster(RenderQueue& renderQueue, Shader* shader, size_t caster) const;
+
+	/** \brief Moves dynamic objects to where they are at given time (in seconds). */
+	void update(float time);
+
+	/** \brief Requests levels of the streamed textures the objects need, seen by given camera - every object asks for its textures
+	*   spread over the size of its bounding sphere on screen.
+	*/
+	void requestTextureLevels(TextureStreamer& streamer, const glm::vec3& cameraPosition, const glm::mat4& projection, int viewportHeight) const;
+
+	/** \brief Gets material texture arrays (empty unless created with SceneShaders::textureArrays). */
+	const TextureArrays& getTextureArrays() const;
+
+	/** \brief Deletes all GPU resources (the OpenGL context must still exist). */
+	void deleteResources();
+
+private:
+	/** Mesh of one scene mesh record - either own buffers, or a cylinder from the mesh cache. */
+	struct GpuMesh
+	{
+		GLuint vao = 0;
+		GLuint vbo = 0;
+		DrawCommand draw;
+		std::shared_ptr<const static_meshes_3D::IndexedCylinder> cylinder;
+		glm::vec3 boundsMin = glm::vec3(0.0f); //! Local bounding box
+		glm::vec3 boundsMax = glm::vec3(0.0f);
+	};
+
+	std::vector<GpuMesh> _meshes; // One per scene mesh record
+	/** Textures of one scene material (null where it has none), shared with other materials through the texture cache,
+	*   or their slots in the texture arrays. */
+	struct MaterialTextures
+	{
+		std::shared_ptr<const CachedTexture> diffuse;
+		std::shared_ptr<const CachedTexture> specular;
+		const TextureSlot* diffuseSlot = nullptr;
+		const TextureSlot* specularSlot = nullptr;
+		GLuint arraySampler = 0; //! Sampler of the texture arrays
+
+		/** \brief Sets the textures and their samplers to texture units 0 and 1 of the packet (with layers and rectangles for arrays). */
+		void apply(RenderPacket& packet) const;
+
+		/** \brief Gets layers and rectangles of the texture arrays for an instance of a batch. */
+		static_meshes_3D::InstanceTextures getInstanceTextures() const;
+	};
+
+	std::vector<MaterialTextures> _materialTextures; // One per scene material
+	TextureArrays _textureArrays; // Material textures of all materials, with SceneShaders::textureArrays only
+	std::vector<std::unique_ptr<static_meshes_3D::CylinderBatch>> _cylinderBatches; // One per slice count and material
+
+	/** Recorded draw of one object or batch, with the program it fills the G-buffer with. */
+	struct ScenePacket
+	{
+		RenderPacket packet; //! Forward draw
+		Shader* gbufferShader = nullptr; //! G-buffer permutation of the lighting program, null for unlit objects or without deferred shading
+		bool lit = true; //! False for unlit objects
+		bool dynamic = false; //! True for objects moving at runtime (always drawn one by one)
+	};
+
+	/** Dynamic object, its packet is moved every update. */
+	struct DynamicObject
+	{
+		size_t packetIndex; //! Index into _packets
+		glm::mat4 model; //! Initial world transformation
+		glm::vec3 boundsMin; //! World bounds in every orientation it turns into
+		glm::vec3 boundsMax;
+	};
+
+	std::vector<ScenePacket> _packets; // Draws of everything but lit cylinders
+	std::vector<ScenePacket> _cylinderPackets; // Lit cylinders, one draw per cylinder
+	std::vector<ScenePacket> _instancedCylinderPackets; // Lit cylinders, one draw per batch
+	std::vector<DynamicObject> _dynamicObjects;
+	std::vector<size_t> _dynamicShadowCasters; // Indices into _dynamicObjects of the lit ones
+
+	/** Textures of one object with its bounding sphere, for choosing the levels to stream. */
+	struct TextureUse
+	{
+		GLuint textures[RenderPacket::MAX_TEXTURES];
+		glm::vec3 center;
+		float radius;
+	};
+
+	std::vector<TextureUse> _textureUses; // One per object with textures
+
+	static GpuMesh createCube();
+	static GpuMesh createShape(const ShapeData& shape, const char* name);
+};
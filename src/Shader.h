@@ -3,20 +3,43 @@
 
 #include <glad/glad.h>
 
+#include "GLDebug.h"
+#include "ParallelShaderCompile.h"
+#include "ProgramBinaryCache.h"
+
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+// stable handle of one uniform, so that hot loops set uniforms without any name lookup
+struct UniformHandle
+{
+	GLint location = -1;
+	bool isValid() const { return location != -1; }
+};
+
 class Shader
 {
 public:
 	unsigned int ID;
-	// constructor generates the shader on the fly
+	// constructor generates the shader on the fly, defines (e.g. "#define NR_POINT_LIGHTS 2\n") are injected
+	// right after #version of every stage, so that one source compiles into several permutations;
+	// with a binary cache, the linked program is taken from disk whenever the driver accepts it.
+	// Compiling and linking are only submitted here, status is first queried by finishLink (called on first use),
+	// so that the driver compiles several programs at once while the caller goes on loading
 	// ------------------------------------------------------------------------
-	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const std::string& defines = std::string(),
+		ProgramBinaryCache* binaryCache = nullptr)
+		: _vertexPath(vertexPath), _fragmentPath(fragmentPath), _geometryPath(geometryPath != nullptr ? geometryPath : ""), _defines(defines),
+		_binaryCache(binaryCache)
 	{
 		// 1. retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
@@ -42,8 +65,8 @@ public:
 			vShaderFile.close();
 			fShaderFile.close();
 			// convert stream into string
-			vertexCode = vShaderStream.str();
-			fragmentCode = fShaderStream.str();
+			vertexCode = injectDefines(vShaderStream.str(), defines);
+			fragmentCode = injectDefines(fShaderStream.str(), defines);
 			// if geometry shader path is present, also load a geometry shader
 			if (geometryPath != nullptr)
 			{
@@ -51,121 +74,340 @@ public:
 				std::stringstream gShaderStream;
 				gShaderStream << gShaderFile.rdbuf();
 				gShaderFile.close();
-				geometryCode = gShaderStream.str();
+				geometryCode = injectDefines(gShaderStream.str(), defines);
 			}
 		}
 		catch (std::ifstream::failure& e)
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
+		// try the program binary first, compiling and linking is skipped entirely on hit
+		ID = glCreateProgram();
+		GL_LABEL(GL_PROGRAM, ID, (std::string(vertexPath) + " + " + fragmentPath).c_str());
+		const bool useBinaryCache = binaryCache != nullptr && binaryCache->isAvailable();
+		const uint64_t binaryKey = useBinaryCache ? binaryCache->makeKey(vertexCode, fragmentCode, geometryCode) : 0;
+		if (useBinaryCache && binaryCache->load(ID, binaryKey))
+		{
+			cacheUniformLocations();
+			return;
+		}
 		const char* vShaderCode = vertexCode.c_str();
 		const char* fShaderCode = fragmentCode.c_str();
 		// 2. compile shaders
-		unsigned int vertex, fragment;
 		// vertex shader
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vShaderCode, NULL);
-		glCompileShader(vertex);
-		checkCompileErrors(vertex, "VERTEX");
+		_vertex = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(_vertex, 1, &vShaderCode, NULL);
+		glCompileShader(_vertex);
 		// fragment Shader
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fShaderCode, NULL);
-		glCompileShader(fragment);
-		checkCompileErrors(fragment, "FRAGMENT");
+		_fragment = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(_fragment, 1, &fShaderCode, NULL);
+		glCompileShader(_fragment);
 		// if geometry shader is given, compile geometry shader
-		unsigned int geometry;
 		if (geometryPath != nullptr)
 		{
 			const char* gShaderCode = geometryCode.c_str();
-			geometry = glCreateShader(GL_GEOMETRY_SHADER);
-			glShaderSource(geometry, 1, &gShaderCode, NULL);
-			glCompileShader(geometry);
-			checkCompileErrors(geometry, "GEOMETRY");
+			_geometry = glCreateShader(GL_GEOMETRY_SHADER);
+			glShaderSource(_geometry, 1, &gShaderCode, NULL);
+			glCompileShader(_geometry);
 		}
 		// shader Program
-		ID = glCreateProgram();
-		glAttachShader(ID, vertex);
-		glAttachShader(ID, fragment);
-		if (geometryPath != nullptr)
-			glAttachShader(ID, geometry);
+		glAttachShader(ID, _vertex);
+		glAttachShader(ID, _fragment);
+		if (_geometry != 0)
+			glAttachShader(ID, _geometry);
+		if (useBinaryCache)
+			binaryCache->prepareForLink(ID);
 		glLinkProgram(ID);
+		_binaryKey = binaryKey;
+		_isLinkPending = true;
+	}
+	// checks without blocking, if the driver has finished linking (always true without parallel compile)
+	// ------------------------------------------------------------------------
+	bool isLinkComplete() const
+	{
+		return !_isLinkPending || ParallelShaderCompile::isProgramComplete(ID);
+	}
+	// waits for compiling and linking to finish, reports errors and queries the uniforms; called on first use
+	// ------------------------------------------------------------------------
+	void finishLink() const
+	{
+		if (!_isLinkPending)
+			return;
+		_isLinkPending = false;
+		checkCompileErrors(_vertex, "VERTEX");
+		checkCompileErrors(_fragment, "FRAGMENT");
+		if (_geometry != 0)
+			checkCompileErrors(_geometry, "GEOMETRY");
 		checkCompileErrors(ID, "PROGRAM");
+		if (_binaryCache != nullptr && _binaryCache->isAvailable())
+			_binaryCache->store(ID, _binaryKey);
+		cacheUniformLocations();
 		// delete the shaders as they're linked into our program now and no longer necessery
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
-		if (geometryPath != nullptr)
-			glDeleteShader(geometry);
-
+		glDeleteShader(_vertex);
+		glDeleteShader(_fragment);
+		if (_geometry != 0)
+			glDeleteShader(_geometry);
+		_vertex = _fragment = _geometry = 0;
+	}
+	// checks, if the program links (waits for it), always false once deleted
+	// ------------------------------------------------------------------------
+	bool isLinked() const
+	{
+		if (ID == 0)
+			return false;
+		finishLink();
+		GLint success = GL_FALSE;
+		glGetProgramiv(ID, GL_LINK_STATUS, &success);
+		return success != GL_FALSE;
+	}
+	// deletes the program, compilation still running is abandoned without waiting for it
+	// ------------------------------------------------------------------------
+	void deleteProgram()
+	{
+		if (_isLinkPending)
+		{
+			glDeleteShader(_vertex);
+			glDeleteShader(_fragment);
+			if (_geometry != 0)
+				glDeleteShader(_geometry);
+			_vertex = _fragment = _geometry = 0;
+			_isLinkPending = false;
+		}
+		glDeleteProgram(ID);
+		ID = 0;
+		_uniformLocations.clear();
+	}
+	// hot reload: checks, if the program is built from given file
+	// ------------------------------------------------------------------------
+	bool usesFile(const std::string& path) const
+	{
+		const auto normalPath = std::filesystem::path(path).lexically_normal();
+		return normalPath == std::filesystem::path(_vertexPath).lexically_normal()
+			|| normalPath == std::filesystem::path(_fragmentPath).lexically_normal()
+			|| (!_geometryPath.empty() && normalPath == std::filesystem::path(_geometryPath).lexically_normal());
+	}
+	// hot reload: submits the same files and defines once more, the result is swapped in with swapProgram once it links
+	// ------------------------------------------------------------------------
+	std::unique_ptr<Shader> rebuild() const
+	{
+		return std::make_unique<Shader>(_vertexPath.c_str(), _fragmentPath.c_str(), _geometryPath.empty() ? nullptr : _geometryPath.c_str(),
+			_defines, _binaryCache);
+	}
+	// hot reload: exchanges linked programs (with their uniform locations), handles taken before are no longer valid
+	// ------------------------------------------------------------------------
+	void swapProgram(Shader& other)
+	{
+		finishLink();
+		other.finishLink();
+		std::swap(ID, other.ID);
+		std::swap(_uniformLocations, other._uniformLocations);
 	}
 	// activate the shader
 	// ------------------------------------------------------------------------
 	void use()
 	{
+		finishLink();
 		glUseProgram(ID);
 	}
+	// binds uniform block of given name to a binding point, returns false if the program has no such block
+	// ------------------------------------------------------------------------
+	bool bindUniformBlock(const char* blockName, GLuint binding) const
+	{
+		finishLink();
+		const GLuint index = glGetUniformBlockIndex(ID, blockName);
+		if (index == GL_INVALID_INDEX)
+			return false;
+		glUniformBlockBinding(ID, index, binding);
+		return true;
+	}
+	// uniform locations, all active uniforms are queried once after link
+	// ------------------------------------------------------------------------
+	GLint getUniformLocation(const std::string& name) const
+	{
+		finishLink();
+		const auto it = _uniformLocations.find(name);
+		return it != _uniformLocations.end() ? it->second : -1;
+	}
+	// ------------------------------------------------------------------------
+	UniformHandle getUniform(const std::string& name) const
+	{
+		UniformHandle handle;
+		handle.location = getUniformLocation(name);
+		return handle;
+	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
 	void setBool(const std::string& name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		glUniform1i(getUniformLocation(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1i(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1f(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string& name, const glm::vec2& value) const
 	{
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform2fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec2(const std::string& name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+		glUniform2f(getUniformLocation(name), x, y);
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string& name, const glm::vec3& value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform3fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		glUniform3f(getUniformLocation(name), x, y, z);
 	}
 	// ------------------------------------------------------------------------
 	void setVec4(const std::string& name, const glm::vec4& value) const
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform4fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec4(const std::string& name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+		glUniform4f(getUniformLocation(name), x, y, z, w);
 	}
 	// ------------------------------------------------------------------------
 	void setMat2(const std::string& name, const glm::mat2& mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat3(const std::string& name, const glm::mat3& mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat4(const std::string& name, const glm::mat4& mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+	}
+	// utility uniform functions by handle (no lookup at all)
+	// ------------------------------------------------------------------------
+	void setInt(UniformHandle handle, int value) const
+	{
+		glUniform1i(handle.location, value);
+	}
+	// ------------------------------------------------------------------------
+	void setIntArray(UniformHandle handle, const int* values, int count) const
+	{
+		glUniform1iv(handle.location, count, values);
+	}
+	// ------------------------------------------------------------------------
+	void setFloatArray(UniformHandle handle, const float* values, int count) const
+	{
+		glUniform1fv(handle.location, count, values);
+	}
+	// ------------------------------------------------------------------------
+	void setVec4Array(UniformHandle handle, const glm::vec4* values, int count) const
+	{
+		glUniform4fv(handle.location, count, &values[0][0]);
+	}
+	// ------------------------------------------------------------------------
+	void setFloat(UniformHandle handle, float value) const
+	{
+		glUniform1f(handle.location, value);
+	}
+	// ------------------------------------------------------------------------
+	void setVec2(UniformHandle handle, const glm::vec2& value) const
+	{
+		glUniform2fv(handle.location, 1, &value[0]);
+	}
+	// ------------------------------------------------------------------------
+	void setVec3(UniformHandle handle, const glm::vec3& value) const
+	{
+		glUniform3fv(handle.location, 1, &value[0]);
+	}
+	// ------------------------------------------------------------------------
+	void setVec4(UniformHandle handle, const glm::vec4& value) const
+	{
+		glUniform4fv(handle.location, 1, &value[0]);
+	}
+	// ------------------------------------------------------------------------
+	void setMat3(UniformHandle handle, const glm::mat3& mat) const
+	{
+		glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+	}
+	// ------------------------------------------------------------------------
+	void setMat4(UniformHandle handle, const glm::mat4& mat) const
+	{
+		glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
 	}
 
 private:
+	mutable std::unordered_map<std::string, GLint> _uniformLocations;
+	// files and defines the program is built from, kept for hot reload
+	std::string _vertexPath, _fragmentPath, _geometryPath;
+	std::string _defines;
+	// state of compiling and linking submitted to the driver, until finishLink collects it
+	mutable bool _isLinkPending = false;
+	mutable GLuint _vertex = 0, _fragment = 0, _geometry = 0;
+	ProgramBinaryCache* _binaryCache = nullptr;
+	uint64_t _binaryKey = 0;
+
+	// inserts defines after the #version line (which must stay first), #line keeps compiler messages pointing to the file
+	// ------------------------------------------------------------------------
+	static std::string injectDefines(const std::string& code, const std::string& defines)
+	{
+		if (defines.empty())
+			return code;
+		const auto versionStart = code.find("#version");
+		const auto versionEnd = versionStart != std::string::npos ? code.find('\n', versionStart) : std::string::npos;
+		if (versionEnd == std::string::npos)
+			return defines + code;
+		const auto versionLine = std::count(code.begin(), code.begin() + versionEnd, '\n') + 1;
+		return code.substr(0, versionEnd + 1) + defines + "#line " + std::to_string(versionLine + 1) + "\n" + code.substr(versionEnd + 1);
+	}
+
+	// fills the name -> location table with every active uniform of the linked program
+	// ------------------------------------------------------------------------
+	void cacheUniformLocations() const
+	{
+		_uniformLocations.clear();
+		GLint numUniforms = 0, maxNameLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &numUniforms);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<GLchar> nameBuffer(maxNameLength > 0 ? maxNameLength : 1);
+		for (GLint i = 0; i < numUniforms; i++)
+		{
+			GLsizei nameLength = 0;
+			GLint size = 0;
+			GLenum type = GL_NONE;
+			glGetActiveUniform(ID, GLuint(i), GLsizei(nameBuffer.size()), &nameLength, &size, &type, nameBuffer.data());
+			const std::string name(nameBuffer.data(), nameLength);
+			const GLint location = glGetUniformLocation(ID, name.c_str());
+			if (location == -1)
+				continue; // members of uniform blocks have no location
+			_uniformLocations[name] = location;
+
+			// arrays of basic types are reported once as "name[0]", but can be set as "name" or "name[i]" too
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			{
+				const std::string arrayName = name.substr(0, name.size() - 3);
+				_uniformLocations[arrayName] = location;
+				for (GLint element = 1; element < size; element++)
+				{
+					const std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+					_uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+				}
+			}
+		}
+	}
+
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
-	void checkCompileErrors(GLuint shader, std::string type)
+	void checkCompileErrors(GLuint shader, std::string type) const
 	{
 		GLint success;
 		GLchar infoLog[1024];
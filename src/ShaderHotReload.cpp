@@ -0,0 +1,133 @@
+// STL
+#include <algorithm>
+#include <iostream>
+
+// Project
+#include "ParallelShaderCompile.h"
+#include "ShaderHotReload.h"
+
+bool ShaderHotReload::initialize(const std::string& directory)
+{
+	_isActive = _watcher.watch(directory);
+	if (_isActive) {
+		std::cout << "Shaders in " << directory << " are reloaded on change" << std::endl;
+	}
+	return _isActive;
+}
+
+bool ShaderHotReload::isActive() const
+{
+	return _isActive;
+}
+
+void ShaderHotReload::add(Shader* shader, SetUpFunction setUp)
+{
+	_entries.push_back({ shader, std::move(setUp), nullptr, 0, false });
+}
+
+void ShaderHotReload::remove(Shader* shader)
+{
+	const auto it = std::find_if(_entries.begin(), _entries.end(), [shader](const Entry& entry) { return entry.shader == shader; });
+	if (it == _entries.end()) {
+		return;
+	}
+
+	if (it->rebuild) {
+		it->rebuild->deleteProgram();
+	}
+	_entries.erase(it);
+}
+
+void ShaderHotReload::update()
+{
+	if (!_isActive) {
+		return;
+	}
+
+	// Rebuilds submitted before the last frame first, so that the driver has had a whole frame for each of them,
+	// without parallel compile the status cannot be queried without waiting, so one rebuild is waited for per frame
+	_frame++;
+	const auto isParallel = ParallelShaderCompile::isAvailable();
+	auto numCollected = 0;
+	for (auto& entry : _entries)
+	{
+		if (!entry.rebuild || entry.submitFrame >= _frame - 1 || !entry.rebuild->isLinkComplete()) {
+			continue;
+		}
+		if (!isParallel && numCollected > 0) {
+			break;
+		}
+		numCollected++;
+
+		// Link errors have been printed by the rebuild, the old program stays
+		if (!entry.rebuild->isLinked())
+		{
+			std::cout << "Shader reload failed, keeping the previous program" << std::endl;
+			entry.rebuild->deleteProgram();
+			entry.rebuild.reset();
+			_numFailures++;
+			continue;
+		}
+
+		entry.shader->swapProgram(*entry.rebuild);
+		entry.rebuild->deleteProgram();
+		entry.rebuild.reset();
+		if (entry.setUp) {
+			entry.setUp(*entry.shader);
+		}
+		_numReloads++;
+	}
+
+	for (const auto& path : _watcher.poll())
+	{
+		auto numPrograms = 0;
+		for (auto& entry : _entries)
+		{
+			if (!entry.shader->usesFile(path)) {
+				continue;
+			}
+
+			// Saved again before the previous rebuild finished, only the latest sources matter
+			if (entry.rebuild)
+			{
+				entry.rebuild->deleteProgram();
+				entry.rebuild.reset();
+			}
+			entry.isChanged = true;
+			numPrograms++;
+		}
+		if (numPrograms > 0) {
+			std::cout << "Reloading " << path << " (" << numPrograms << " programs)" << std::endl;
+		}
+	}
+
+	// without parallel compile the driver may compile right here, so one program is submitted per frame
+	for (auto& entry : _entries)
+	{
+		if (!entry.isChanged) {
+			continue;
+		}
+		entry.rebuild = entry.shader->rebuild();
+		entry.submitFrame = _frame;
+		entry.isChanged = false;
+		if (!isParallel) {
+			break;
+		}
+	}
+}
+
+void ShaderHotReload::clear()
+{
+	for (auto& entry : _entries)
+	{
+		if (entry.rebuild) {
+			entry.rebuild->deleteProgram();
+		}
+	}
+	_entries.clear();
+}
+
+void ShaderHotReload::printStats(std::ostream& os) const
+{
+	os << "Shader hot reload: " << _numReloads << " programs reloaded, " << _numFailures << " failed" << std::endl;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Project
+#include "FileWatcher.h"
+#include "shader.h"
+
+/**
+  Rebuilds programs whose source files change on disk, so that shaders can be edited while the application runs.
+  Changed programs are only submitted for compilation, the new program is collected in a later frame once
+  the driver reports it complete, and swapped in only if it links - on error the old program keeps rendering.
+  Without parallel shader compile the driver cannot report completion and may compile on the render thread, so reloading
+  does stall then - it's spread over frames instead, one program submitted and one collected (waited for) per frame.
+*/
+class ShaderHotReload
+{
+public:
+	/** Restores per-program state (samplers, uniform block bindings, constants) of a freshly swapped program. */
+	typedef std::function<void(Shader&)> SetUpFunction;
+
+	ShaderHotReload() = default;
+	ShaderHotReload(const ShaderHotReload&) = delete;
+	ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+	/** \brief Starts watching shader sources in given directory.
+	*   \return True if changes can be detected, false otherwise.
+	*/
+	bool initialize(const std::string& directory);
+
+	/** \brief Checks, if the sources are being watched. */
+	bool isActive() const;
+
+	/** \brief Starts reloading given program, set up function is called after every swap. */
+	void add(Shader* shader, SetUpFunction setUp = SetUpFunction());
+
+	/** \brief Stops reloading given program (abandons its rebuild in progress). */
+	void remove(Shader* shader);
+
+	/** \brief Swaps in rebuilt programs, that have finished linking, and submits programs, whose files changed.
+	*   Never waits for the driver with parallel shader compile, without it waits for one program at most, call once per frame before drawing.
+	*/
+	void update();
+
+	/** \brief Forgets all programs and deletes rebuilds in progress (the OpenGL context must still exist). */
+	void clear();
+
+	/** \brief Prints number of reloaded and failed programs in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+private:
+	struct Entry
+	{
+		Shader* shader; //! Program rendering the scene
+		SetUpFunction setUp; //! State to restore after swap
+		std::unique_ptr<Shader> rebuild; //! Program being compiled from changed sources, null if none
+		uint64_t submitFrame; //! Frame the rebuild has been submitted in
+		bool isChanged; //! Sources changed, rebuild not submitted yet
+	};
+
+	FileWatcher _watcher;
+	std::vector<Entry> _entries;
+	bool _isActive = false;
+	uint64_t _frame = 0; // Updates so far
+
+	uint64_t _numReloads = 0; // Programs swapped in
+	uint64_t _numFailures = 0; // Rebuilds, that did not link
+};
@@ -0,0 +1,356 @@
+// STL
+#include <algorithm>
+#include <chrono>
+
+// GLM
+#include <glm/gtc/matrix_transform.hpp>
+
+// Project
+#include "ClusteredLighting.h"
+#include "GLDebug.h"
+#include "ShadowMaps.h"
+
+namespace {
+
+	// Near plane of the cube faces, objects closer to the light than this do not cast shadows
+	const float SHADOW_NEAR_PLANE = 0.05f;
+
+	// Shadows stop at the far plane of the camera, even if the light reaches further
+	const float MAX_SHADOW_DISTANCE = 100.0f;
+
+	// Slope-scaled depth offset of the shadow casters, against shadow acne
+	const float POLYGON_OFFSET_FACTOR = 2.0f;
+	const float POLYGON_OFFSET_UNITS = 4.0f;
+
+	// Direction and up vector of every cube face, must match SHADOW_FACE_FORWARD and SHADOW_FACE_UP in multiple_lights.fs
+	const glm::vec3 FACE_FORWARD[ShadowMaps::NUM_FACES] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const glm::vec3 FACE_UP[ShadowMaps::NUM_FACES] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	const unsigned int ALL_FACES = (1u << ShadowMaps::NUM_FACES) - 1;
+
+	// Bit per cube face of the light the box may be seen in. A point belongs to the face of its major axis, so the box
+	// must reach along the face direction at least as far as its nearest point is off the other two axes - conservative,
+	// a face is never missed, a box near a cube edge may get the neighbouring face too.
+	unsigned int getTouchedFaces(const glm::vec3& lightPosition, float farPlane, const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		const auto relativeMin = boxMin - lightPosition;
+		const auto relativeMax = boxMax - lightPosition;
+		const auto closest = glm::max(glm::max(relativeMin, -relativeMax), glm::vec3(0.0f));
+		if (glm::dot(closest, closest) > farPlane * farPlane) {
+			return 0;
+		}
+
+		unsigned int faces = 0;
+		for (auto face = 0; face < ShadowMaps::NUM_FACES; face++)
+		{
+			const auto axis = face / 2;
+			const auto reach = face % 2 == 0 ? relativeMax[axis] : -relativeMin[axis];
+			if (reach > 0.0f && closest[(axis + 1) % 3] <= reach && closest[(axis + 2) % 3] <= reach) {
+				faces |= 1u << face;
+			}
+		}
+		return faces;
+	}
+
+} // namespace
+
+ShadowMaps::~ShadowMaps()
+{
+	deleteResources();
+}
+
+void ShadowMaps::create(ProgramBinaryCache* binaryCache)
+{
+	deleteResources();
+
+	_depthShader = std::make_unique<Shader>("res/shaders/shadow_depth.vs", "res/shaders/shadow_depth.fs", nullptr, std::string(), binaryCache);
+	if (_hotReload != nullptr) {
+		_hotReload->add(_depthShader.get());
+	}
+	_shadowUniforms.create("ShadowData", SHADOW_BLOCK_BINDING, sizeof(ShadowBlock));
+}
+
+void ShadowMaps::setHotReload(ShaderHotReload* hotReload)
+{
+	if (_depthShader)
+	{
+		if (_hotReload != nullptr) {
+			_hotReload->remove(_depthShader.get());
+		}
+		if (hotReload != nullptr) {
+			hotReload->add(_depthShader.get());
+		}
+	}
+	_hotReload = hotReload;
+}
+
+void ShadowMaps::setLights(const Scene& scene)
+{
+	const auto numLights = std::min(scene.getNumLights(), MAX_SHADOWED_LIGHTS);
+	_lights.resize(numLights, { glm::vec3(0.0f), 0.0f, true, 0 });
+
+	ShadowBlock block = {};
+	for (uint32_t i = 0; i < numLights; i++)
+	{
+		const auto& record = scene.getLight(i);
+		const auto farPlane = std::min(ClusteredLighting::computeInfluenceRadius(record), MAX_SHADOW_DISTANCE);
+		auto& light = _lights[i];
+		if (light.position != record.position || light.farPlane != farPlane)
+		{
+			light.position = record.position;
+			light.farPlane = farPlane;
+			light.isOutdated = true;
+		}
+		block.lights[i] = glm::vec4(SHADOW_NEAR_PLANE, farPlane, farPlane > SHADOW_NEAR_PLANE ? 1.0f : 0.0f, 0.0f);
+	}
+	block.atlasLayout = glm::vec4(float(FACE_SIZE), float(std::max(int(numLights), 1)), 0.0f, 0.0f);
+	_shadowUniforms.update(&block);
+
+	// atlases grow or shrink with the number of lights, the dynamic one is created on first use
+	if (int(numLights) != _numRows)
+	{
+		deleteAtlases();
+		createAtlas(STATIC_ATLAS);
+		invalidate();
+	}
+	_stats.numShadowedLights = numLights;
+}
+
+void ShadowMaps::invalidate()
+{
+	for (auto& light : _lights) {
+		light.isOutdated = true;
+	}
+}
+
+void ShadowMaps::update(const SceneResources& resources)
+{
+	_renderQueue.resetStats();
+	if (_lights.empty()) {
+		return;
+	}
+	GL_DEBUG_GROUP("Shadow maps");
+	const auto start = std::chrono::steady_clock::now();
+
+	GLint framebuffer = 0;
+	GLint viewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glEnable(GL_SCISSOR_TEST);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+
+	// Static objects, only into faces of lights that moved since they were rendered
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffers[STATIC_ATLAS]);
+	unsigned int renderedLights = 0;
+	for (size_t i = 0; i < _lights.size(); i++)
+	{
+		if (_lights[i].isOutdated)
+		{
+			for (auto face = 0; face < NUM_FACES; face++) {
+				renderFace(i, face, resources, nullptr);
+			}
+			_lights[i].isOutdated = false;
+			renderedLights |= 1u << i;
+			_stats.staticFacesRendered += NUM_FACES;
+		}
+	}
+
+	// Dynamic objects, into the faces they touch of the copy of the cache
+	auto sampledAtlas = _atlases[STATIC_ATLAS];
+	if (resources.getNumDynamicShadowCasters() > 0)
+	{
+		createAtlas(DYNAMIC_ATLAS);
+		for (size_t i = 0; i < _lights.size(); i++) {
+			updateDynamicFaces(i, resources, (renderedLights & (1u << i)) != 0);
+		}
+		_isDynamicAtlasCurrent = true;
+		sampledAtlas = _atlases[DYNAMIC_ATLAS];
+	}
+	else {
+		_isDynamicAtlasCurrent = _isDynamicAtlasCurrent && renderedLights == 0;
+	}
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, GLuint(framebuffer));
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	glActiveTexture(GL_TEXTURE0 + SHADOW_ATLAS_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, sampledAtlas);
+	glActiveTexture(GL_TEXTURE0);
+
+	_stats.numUpdates++;
+	const std::chrono::duration<double, std::milli> updateTime = std::chrono::steady_clock::now() - start;
+	_stats.updateTimeMs += updateTime.count();
+}
+
+const ShadowMapsStats& ShadowMaps::getStats() const
+{
+	return _stats;
+}
+
+const RenderQueueStats& ShadowMaps::getRenderQueueStats() const
+{
+	return _renderQueue.getStats();
+}
+
+void ShadowMaps::printStats(std::ostream& os) const
+{
+	os << "Shadow maps: " << _stats.numShadowedLights << " shadowed lights, " << _stats.staticFacesRendered << " cached faces rendered, "
+		<< _stats.dynamicFacesRendered << " faces with dynamic objects, " << _stats.facesCopied << " faces copied over " << _stats.numUpdates << " frames, "
+		<< (_stats.numUpdates > 0 ? _stats.updateTimeMs / _stats.numUpdates : 0.0) << " ms per frame on average" << std::endl;
+}
+
+void ShadowMaps::deleteResources()
+{
+	deleteAtlases();
+	if (_depthShader)
+	{
+		if (_hotReload != nullptr) {
+			_hotReload->remove(_depthShader.get());
+		}
+		_depthShader->deleteProgram();
+		_depthShader.reset();
+	}
+	_shadowUniforms.deleteBuffer();
+	_lights.clear();
+}
+
+void ShadowMaps::createAtlas(AtlasIndex index)
+{
+	if (_atlases[index] != 0) {
+		return;
+	}
+	_numRows = int(_lights.size());
+
+	// compared against in the lighting shader (sampler2DShadow), linear filter gives 2x2 PCF on most hardware
+	glGenTextures(1, &_atlases[index]);
+	glBindTexture(GL_TEXTURE_2D, _atlases[index]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, FACE_SIZE * NUM_FACES, FACE_SIZE * std::max(_numRows, 1), 0,
+		GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GL_LABEL(GL_TEXTURE, _atlases[index], index == STATIC_ATLAS ? "Static shadow atlas" : "Dynamic shadow atlas");
+
+	glGenFramebuffers(1, &_framebuffers[index]);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffers[index]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _atlases[index], 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GL_LABEL(GL_FRAMEBUFFER, _framebuffers[index], index == STATIC_ATLAS ? "Static shadow atlas" : "Dynamic shadow atlas");
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowMaps::renderFace(size_t light, int face, const SceneResources& resources, const std::vector<size_t>* casters)
+{
+	// scissor keeps the clear within the face, cached faces start empty, dynamic ones from the copied cache
+	const auto& shadowLight = _lights[light];
+	glViewport(face * FACE_SIZE, int(light) * FACE_SIZE, FACE_SIZE, FACE_SIZE);
+	glScissor(face * FACE_SIZE, int(light) * FACE_SIZE, FACE_SIZE, FACE_SIZE);
+	if (casters == nullptr) {
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	const auto projection = glm::perspective(glm::radians(90.0f), 1.0f, SHADOW_NEAR_PLANE, shadowLight.farPlane);
+	const auto view = glm::lookAt(shadowLight.position, shadowLight.position + FACE_FORWARD[face], FACE_UP[face]);
+	_depthShader->use();
+	_depthShader->setMat4("lightViewProjection", projection * view);
+	_renderQueue.setCamera(shadowLight.position, FACE_FORWARD[face], shadowLight.farPlane);
+	if (casters == nullptr) {
+		resources.submitShadowCasters(_renderQueue, _depthShader.get());
+	}
+	else
+	{
+		for (const auto caster : *casters) {
+			resources.submitDynamicShadowCaster(_renderQueue, _depthShader.get(), caster);
+		}
+	}
+	_renderQueue.flush();
+}
+
+void ShadowMaps::updateDynamicFaces(size_t light, const SceneResources& resources, bool isCacheRendered)
+{
+	auto& shadowLight = _lights[light];
+	unsigned int touchedFaces = 0;
+	for (auto& casters : _faceCasters) {
+		casters.clear();
+	}
+	for (size_t caster = 0; caster < resources.getNumDynamicShadowCasters(); caster++)
+	{
+		glm::vec3 boundsMin, boundsMax;
+		resources.getDynamicShadowCasterBounds(caster, boundsMin, boundsMax);
+		const auto faces = getTouchedFaces(shadowLight.position, shadowLight.farPlane, boundsMin, boundsMax);
+		for (auto face = 0; face < NUM_FACES; face++)
+		{
+			if ((faces & (1u << face)) != 0) {
+				_faceCasters[face].push_back(caster);
+			}
+		}
+		touchedFaces |= faces;
+	}
+
+	// faces with dynamic objects now or in the last update start over from the cache, all of them when the cache has changed,
+	// neighbouring faces are copied at once
+	const auto copiedFaces = !_isDynamicAtlasCurrent || isCacheRendered ? ALL_FACES : touchedFaces | shadowLight.dynamicFaces;
+	if (copiedFaces != 0)
+	{
+		glDisable(GL_SCISSOR_TEST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffers[STATIC_ATLAS]);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _framebuffers[DYNAMIC_ATLAS]);
+		for (auto face = 0; face < NUM_FACES; face++)
+		{
+			if ((copiedFaces & (1u << face)) == 0) {
+				continue;
+			}
+			auto end = face + 1;
+			while (end < NUM_FACES && (copiedFaces & (1u << end)) != 0) {
+				end++;
+			}
+			const auto x0 = face * FACE_SIZE, x1 = end * FACE_SIZE, y0 = int(light) * FACE_SIZE, y1 = y0 + FACE_SIZE;
+			glBlitFramebuffer(x0, y0, x1, y1, x0, y0, x1, y1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+			_stats.facesCopied += uint64_t(end - face);
+			face = end;
+		}
+		glEnable(GL_SCISSOR_TEST);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffers[DYNAMIC_ATLAS]);
+	for (auto face = 0; face < NUM_FACES; face++)
+	{
+		if (!_faceCasters[face].empty())
+		{
+			renderFace(light, face, resources, &_faceCasters[face]);
+			_stats.dynamicFacesRendered++;
+		}
+	}
+	shadowLight.dynamicFaces = touchedFaces;
+}
+
+void ShadowMaps::deleteAtlases()
+{
+	for (auto i = 0; i < NUM_ATLASES; i++)
+	{
+		if (_atlases[i] != 0)
+		{
+			glDeleteFramebuffers(1, &_framebuffers[i]);
+			glDeleteTextures(1, &_atlases[i]);
+			_framebuffers[i] = _atlases[i] = 0;
+		}
+	}
+	_numRows = 0;
+	_isDynamicAtlasCurrent = false;
+}
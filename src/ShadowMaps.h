@@ -0,0 +1,133 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <glad/glad.h>
+
+// Project
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "SceneResources.h"
+#include "ShaderHotReload.h"
+#include "UniformBlocks.h"
+#include "shader.h"
+
+/** Texture unit the shadow atlas is bound to (0..8 belong to materials, clustered lighting and the G-buffer). */
+enum ShadowTextureUnit
+{
+	SHADOW_ATLAS_TEXTURE_UNIT = 9 //! "shadowAtlas" - depth of all shadow cube faces
+};
+
+/**
+  Statistics of the shadow maps, over the whole run.
+*/
+struct ShadowMapsStats
+{
+	uint32_t numShadowedLights = 0; //! Lights casting shadows
+	uint64_t numUpdates = 0; //! Frames the shadows have been updated for
+	uint64_t staticFacesRendered = 0; //! Cube faces rendered into the static cache
+	uint64_t dynamicFacesRendered = 0; //! Cube faces dynamic objects have been composited into
+	uint64_t facesCopied = 0; //! Cube faces copied from the static atlas into the dynamic one
+	double updateTimeMs = 0.0; //! CPU time of all updates
+};
+
+/**
+  Shadows of the first MAX_SHADOWED_LIGHTS point lights. Every light has a row of six cube faces in a depth atlas
+  (OpenGL 3.3 has no cube map arrays, and one atlas needs one sampler only). Static objects are rendered into a cached
+  atlas, only for lights that have moved or after static objects have. If the scene has dynamic objects, they are
+  composited into a copy of the cached atlas - only faces their bounds touch get copied and rendered again (and faces
+  they have left get copied once more), the rest of the copy stays as it is, so that the cost of a frame follows
+  what changed in it, not the size of the scene.
+*/
+class ShadowMaps
+{
+public:
+	static const int FACE_SIZE = 512; //! Size of one cube face in texels
+	static const int NUM_FACES = 6;
+
+	ShadowMaps() = default;
+	~ShadowMaps();
+
+	ShadowMaps(const ShadowMaps&) = delete;
+	ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+	/** \brief Submits the depth program (linked from binaries of given cache whenever possible) and creates the "ShadowData" block. */
+	void create(ProgramBinaryCache* binaryCache = nullptr);
+
+	/** \brief Registers the depth program for hot reload. */
+	void setHotReload(ShaderHotReload* hotReload);
+
+	/** \brief Takes the shadowed lights of the scene, cached faces of lights that moved or changed their reach are rendered again. */
+	void setLights(const Scene& scene);
+
+	/** \brief Marks all cached faces outdated, to be called when static objects move. */
+	void invalidate();
+
+	/** \brief Renders outdated cached faces, composites dynamic objects and binds the atlas for lighting.
+	*   Framebuffer binding and viewport are kept.
+	*/
+	void update(const SceneResources& resources);
+
+	/** \brief Gets statistics of all updates so far. */
+	const ShadowMapsStats& getStats() const;
+
+	/** \brief Gets statistics of the shadow caster draws of the last update. */
+	const RenderQueueStats& getRenderQueueStats() const;
+
+	/** \brief Prints statistics of all updates so far in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+	/** \brief Deletes atlases, framebuffers and the program (the OpenGL context must still exist). */
+	void deleteResources();
+
+private:
+	/** One shadowed light. */
+	struct ShadowLight
+	{
+		glm::vec3 position;
+		float farPlane; //! Influence radius of the light, nothing is shadowed beyond it
+		bool isOutdated; //! Its cached faces must be rendered again
+		unsigned int dynamicFaces; //! Bit per face of the dynamic atlas holding dynamic objects, those differ from the cached ones
+	};
+
+	enum AtlasIndex
+	{
+		STATIC_ATLAS = 0, //! Static objects only, rendered when outdated
+		DYNAMIC_ATLAS = 1, //! Copy of the static one with dynamic objects, rendered every frame
+		NUM_ATLASES = 2
+	};
+
+	GLuint _atlases[NUM_ATLASES] = {}; // Depth textures, one row of faces per light
+	GLuint _framebuffers[NUM_ATLASES] = {}; // Depth-only framebuffers of the atlases
+	int _numRows = 0; // Rows the atlases have been created with
+
+	std::vector<ShadowLight> _lights;
+	std::unique_ptr<Shader> _depthShader; // shadow_depth.vs/fs
+	ShaderHotReload* _hotReload = nullptr;
+	UniformBuffer _shadowUniforms; // "ShadowData" block
+	RenderQueue _renderQueue; // Shadow casters of one face
+	std::vector<size_t> _faceCasters[NUM_FACES]; // Dynamic shadow casters touching each face of the light being updated
+	bool _isDynamicAtlasCurrent = false; // Faces of the dynamic atlas without dynamic objects match the cached ones
+	ShadowMapsStats _stats;
+
+	/** \brief Creates atlas of given index with enough rows for all lights (if it does not exist yet). */
+	void createAtlas(AtlasIndex index);
+
+	/** \brief Renders static objects (casters null) or given dynamic shadow casters into one face of a light, into the bound atlas. */
+	void renderFace(size_t light, int face, const SceneResources& resources, const std::vector<size_t>* casters);
+
+	/** \brief Composites dynamic shadow casters into the faces of one light they touch, in the dynamic atlas.
+	*   \param isCacheRendered True if the cached faces of the light have just been rendered (all its faces must be copied)
+	*/
+	void updateDynamicFaces(size_t light, const SceneResources& resources, bool isCacheRendered);
+
+	/** \brief Deletes both atlases and their framebuffers. */
+	void deleteAtlases();
+};
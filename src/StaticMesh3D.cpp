@@ -48,6 +48,11 @@ namespace static_meshes_3D {
         return _hasNormals;
     }
 
+    GLuint StaticMesh3D::getVAO() const
+    {
+        return _vao;
+    }
+
     int StaticMesh3D::getVertexByteSize() const
     {
         int result = 0;
@@ -64,7 +69,7 @@ namespace static_meshes_3D {
         return result;
     }
 
-    void StaticMesh3D::setVertexAttributesPointers(int numVertices)
+    void StaticMesh3D::setVertexAttributesPointers(int numVertices) const
     {
         uint64_t offset = 0;
         if (hasPositions())
@@ -24,6 +24,9 @@ namespace static_meshes_3D {
 		/** \brief  Renders static mesh as points only. */
 		virtual void renderPoints() const {}
 
+		/** \brief  Renders given number of static mesh instances (per-instance data are up to the caller). */
+		virtual void renderInstanced(int numInstances) const {}
+
 		/** \brief  Deletes static mesh data. */
 		virtual void deleteMesh();
 
@@ -47,6 +50,16 @@ namespace static_meshes_3D {
 		*/
 		int getVertexByteSize() const;
 
+		/** \brief  Gets how many bytes of mesh data are held in GPU buffers.
+		*   \return Size in bytes, or 0 if mesh is not initialized.
+		*/
+		virtual size_t getGPUByteSize() const { return 0; }
+
+		/** \brief  Gets VAO ID from OpenGL, e.g. to attach instance attributes to it.
+		*   \return VAO ID, or 0 if mesh is not initialized.
+		*/
+		GLuint getVAO() const;
+
 	protected:
 		bool _hasPositions = false; //!< Flag telling, if we have vertex positions
 		bool _hasTextureCoordinates = false; //!< Flag telling, if we have texture coordinates
@@ -60,7 +73,7 @@ namespace static_meshes_3D {
 		virtual void initializeData() {};
 
 		/** \brief  Sets vertex attribute pointers in a standard way. */
-		void setVertexAttributesPointers(int numVertices);
+		void setVertexAttributesPointers(int numVertices) const;
 	};
 
 }; // namespace static_meshes_3D
\ No newline at end of file
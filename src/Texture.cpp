@@ -0,0 +1,62 @@
+#include <glad/glad.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <iostream>
+
+#include "GLDebug.h"
+#include "Texture.h"
+#include "TextureStorage.h"
+
+bool TextureOptions::operator==(const TextureOptions& other) const
+{
+	return repeat == other.repeat && mipmaps == other.mipmaps && srgb == other.srgb;
+}
+
+GLuint createSampler(const TextureOptions& options)
+{
+	const GLint wrap = options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	GLuint sampler;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, options.mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return sampler;
+}
+
+unsigned int loadTexture(char const* path, const TextureOptions& options)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+
+	int width, height, nrComponents;
+	stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis
+	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+	if (data)
+	{
+		// storage of the whole mip chain first, then level 0 with tightly packed rows, the rest is filtered from it
+		const auto numLevels = options.mipmaps ? TextureStorage::getNumLevels(width, height) : 1;
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		GL_LABEL(GL_TEXTURE, textureID, path);
+		TextureStorage::allocate(TextureStorage::getInternalFormat(nrComponents, options.srgb), width, height, numLevels);
+		TextureStorage::setSwizzle(GL_TEXTURE_2D, nrComponents);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, TextureStorage::getPixelFormat(nrComponents), GL_UNSIGNED_BYTE, data);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		if (numLevels > 1) {
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		stbi_image_free(data);
+	}
+	else
+	{
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+		stbi_image_free(data);
+	}
+
+	return textureID;
+}
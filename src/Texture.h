@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/**
+  Options a 2D texture is loaded with, textures of the same image with different options are different textures.
+*/
+struct TextureOptions
+{
+	bool repeat = true; //! Repeating texture coordinates, clamped to edge otherwise
+	bool mipmaps = true; //! Mipmaps are generated and sampled (trilinear), bilinear filtering of level 0 otherwise
+	bool srgb = false; //! Color channels are stored as sRGB and converted to linear when sampled (lighting is not gamma correct yet, so off)
+
+	bool operator==(const TextureOptions& other) const;
+};
+
+/** \brief Creates sampler object with wrapping and filtering of given options, to be shared by all textures loaded with them. */
+GLuint createSampler(const TextureOptions& options);
+
+/** \brief Loads 2D texture from an image file into storage of sized format (with all mipmaps unless given options say otherwise).
+*   Wrapping and filtering are left to the sampler of the options.
+*   \return OpenGL texture ID, texture stays empty if the image could not be loaded.
+*/
+unsigned int loadTexture(const char* path, const TextureOptions& options = TextureOptions());
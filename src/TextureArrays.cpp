@@ -0,0 +1,266 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+// Project
+#include "GLDebug.h"
+#include "stb_image.h"
+#include "TextureArrays.h"
+#include "TextureStorage.h"
+
+namespace {
+
+	// Rounds atlas positions up, so that every image starts on a texel boundary of the last atlas level
+	const int ATLAS_ALIGNMENT = 1 << (TextureArrays::ATLAS_LEVELS - 1);
+
+	int alignUp(int value)
+	{
+		return (value + ATLAS_ALIGNMENT - 1) / ATLAS_ALIGNMENT * ATLAS_ALIGNMENT;
+	}
+
+	// Wraps coordinate into [0, size), gutter texels repeat the opposite edge of the image
+	int wrap(int coordinate, int size)
+	{
+		const auto wrapped = coordinate % size;
+		return wrapped < 0 ? wrapped + size : wrapped;
+	}
+
+} // namespace
+
+TextureArrays::~TextureArrays()
+{
+	deleteResources();
+}
+
+void TextureArrays::build(const std::vector<std::string>& paths, const TextureOptions& options)
+{
+	const auto start = std::chrono::steady_clock::now();
+	deleteResources();
+	_stats = TextureArraysStats();
+	_slots.assign(paths.size(), TextureSlot());
+
+	// decoding dominates, so every image gets a thread of its own, the flip flag is global to stb_image
+	stbi_set_flip_vertically_on_load(true);
+	std::vector<std::future<Image>> decoding;
+	decoding.reserve(paths.size());
+	for (const auto& path : paths)
+	{
+		decoding.push_back(std::async(std::launch::async, [path]() {
+			Image image;
+			image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+			return image;
+		}));
+	}
+
+	std::vector<Image> images;
+	images.reserve(paths.size());
+	for (auto& image : decoding) {
+		images.push_back(image.get());
+	}
+
+	// images of the same size and format share an array, the rest goes to the atlas
+	std::map<std::tuple<int, int, int>, std::vector<size_t>> groups;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (images[i].pixels == nullptr)
+		{
+			std::cout << "Texture failed to load at path: " << paths[i] << std::endl;
+			continue;
+		}
+		groups[std::make_tuple(images[i].width, images[i].height, images[i].channels)].push_back(i);
+		_stats.numImages++;
+	}
+
+	std::vector<size_t> atlasIndices;
+	for (const auto& group : groups)
+	{
+		const auto& image = images[group.second.front()];
+		const bool fitsAtlas = image.width + 2 * ATLAS_GUTTER <= ATLAS_PAGE_SIZE && image.height + 2 * ATLAS_GUTTER <= ATLAS_PAGE_SIZE;
+		if (group.second.size() > 1 || !fitsAtlas) {
+			createArray(group.second, images, options);
+		}
+		else {
+			atlasIndices.push_back(group.second.front());
+		}
+	}
+
+	// an atlas of one image would only add a gutter
+	if (atlasIndices.size() == 1) {
+		createArray(atlasIndices, images, options);
+	}
+	else if (!atlasIndices.empty()) {
+		createAtlas(atlasIndices, images, options);
+	}
+
+	for (auto& image : images) {
+		stbi_image_free(image.pixels);
+	}
+
+	TextureOptions samplerOptions = options;
+	samplerOptions.repeat = true;
+	_sampler = createSampler(samplerOptions);
+
+	const std::chrono::duration<double, std::milli> buildTime = std::chrono::steady_clock::now() - start;
+	_stats.buildTimeMs = buildTime.count();
+}
+
+const TextureSlot& TextureArrays::getSlot(size_t index) const
+{
+	static const TextureSlot EMPTY_SLOT;
+	return index < _slots.size() ? _slots[index] : EMPTY_SLOT;
+}
+
+GLuint TextureArrays::getSampler() const
+{
+	return _sampler;
+}
+
+const TextureArraysStats& TextureArrays::getStats() const
+{
+	return _stats;
+}
+
+void TextureArrays::printStats(std::ostream& os) const
+{
+	os << "Texture arrays: " << _stats.numImages << " images in " << _stats.numArrays << " arrays ("
+		<< _stats.numLayers << " layers, " << _stats.numAtlasImages << " images in " << _stats.numAtlasPages << " atlas pages), built in "
+		<< _stats.buildTimeMs << " ms" << std::endl;
+}
+
+void TextureArrays::deleteResources()
+{
+	if (!_arrays.empty()) {
+		glDeleteTextures(GLsizei(_arrays.size()), _arrays.data());
+	}
+	_arrays.clear();
+	_slots.clear();
+
+	if (_sampler != 0) {
+		glDeleteSamplers(1, &_sampler);
+	}
+	_sampler = 0;
+}
+
+void TextureArrays::createArray(const std::vector<size_t>& indices, const std::vector<Image>& images, const TextureOptions& options)
+{
+	const auto& first = images[indices.front()];
+	const auto numLayers = GLsizei(indices.size());
+	const auto numLevels = options.mipmaps ? TextureStorage::getNumLevels(first.width, first.height) : 1;
+
+	GLuint array;
+	glGenTextures(1, &array);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+	GL_LABEL(GL_TEXTURE, array, "Texture array");
+	TextureStorage::allocateArray(TextureStorage::getInternalFormat(first.channels, options.srgb), first.width, first.height, numLayers, numLevels);
+	TextureStorage::setSwizzle(GL_TEXTURE_2D_ARRAY, first.channels);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (GLsizei layer = 0; layer < numLayers; layer++)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, first.width, first.height, 1,
+			TextureStorage::getPixelFormat(first.channels), GL_UNSIGNED_BYTE, images[indices[layer]].pixels);
+
+		auto& slot = _slots[indices[layer]];
+		slot.array = array;
+		slot.layer = float(layer);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (numLevels > 1) {
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	_arrays.push_back(array);
+	_stats.numArrays++;
+	_stats.numLayers += uint32_t(numLayers);
+}
+
+void TextureArrays::createAtlas(std::vector<size_t> indices, const std::vector<Image>& images, const TextureOptions& options)
+{
+	// shelves fill best with the tallest images first
+	std::sort(indices.begin(), indices.end(), [&images](size_t a, size_t b) {
+		return images[a].height > images[b].height;
+	});
+
+	// RGBA8 pages, images read as in a texture of their own - grey and alpha ones as grey RGB, missing channels as 0 for green and blue, 1 for alpha
+	const size_t pageBytes = size_t(ATLAS_PAGE_SIZE) * ATLAS_PAGE_SIZE * 4;
+	std::vector<std::vector<unsigned char>> pages;
+	int x = 0, y = 0, shelfHeight = 0;
+	for (const auto index : indices)
+	{
+		const auto& image = images[index];
+		const auto width = alignUp(image.width + 2 * ATLAS_GUTTER);
+		const auto height = alignUp(image.height + 2 * ATLAS_GUTTER);
+		if (x + width > ATLAS_PAGE_SIZE)
+		{
+			x = 0;
+			y += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (pages.empty() || y + height > ATLAS_PAGE_SIZE)
+		{
+			pages.emplace_back(pageBytes, 0);
+			x = 0;
+			y = 0;
+			shelfHeight = 0;
+		}
+
+		auto& page = pages.back();
+		for (int row = -ATLAS_GUTTER; row < image.height + ATLAS_GUTTER; row++)
+		{
+			const auto sourceRow = image.pixels + size_t(wrap(row, image.height)) * image.width * image.channels;
+			auto destination = page.data() + (size_t(y + ATLAS_GUTTER + row) * ATLAS_PAGE_SIZE + x) * 4;
+			for (int column = -ATLAS_GUTTER; column < image.width + ATLAS_GUTTER; column++, destination += 4)
+			{
+				const auto source = sourceRow + wrap(column, image.width) * image.channels;
+				if (image.channels == 2)
+				{
+					destination[0] = destination[1] = destination[2] = source[0];
+					destination[3] = source[1];
+					continue;
+				}
+				destination[0] = source[0];
+				destination[1] = image.channels > 1 ? source[1] : 0;
+				destination[2] = image.channels > 2 ? source[2] : 0;
+				destination[3] = image.channels > 3 ? source[3] : 255;
+			}
+		}
+
+		auto& slot = _slots[index];
+		slot.layer = float(pages.size() - 1);
+		slot.rect = glm::vec4(float(image.width), float(image.height), float(x + ATLAS_GUTTER), float(y + ATLAS_GUTTER)) / float(ATLAS_PAGE_SIZE);
+
+		x += width;
+		shelfHeight = std::max(shelfHeight, height);
+	}
+
+	const auto numLayers = GLsizei(pages.size());
+	const auto numLevels = options.mipmaps ? ATLAS_LEVELS : 1;
+
+	GLuint array;
+	glGenTextures(1, &array);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+	GL_LABEL(GL_TEXTURE, array, "Texture atlas");
+	TextureStorage::allocateArray(TextureStorage::getInternalFormat(4, options.srgb), ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, numLayers, numLevels);
+	for (GLsizei layer = 0; layer < numLayers; layer++) {
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, pages[layer].data());
+	}
+	if (numLevels > 1) {
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	for (const auto index : indices) {
+		_slots[index].array = array;
+	}
+
+	_arrays.push_back(array);
+	_stats.numArrays++;
+	_stats.numAtlasImages += uint32_t(indices.size());
+	_stats.numAtlasPages += uint32_t(numLayers);
+}
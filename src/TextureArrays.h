@@ -0,0 +1,101 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <glad/glad.h>
+
+// Project
+#include "Texture.h"
+
+/**
+  Where one image ended up - the array texture, its layer and the rectangle within the layer.
+*/
+struct TextureSlot
+{
+	GLuint array = 0; //! GL_TEXTURE_2D_ARRAY holding the image, 0 if it could not be loaded
+	float layer = 0.0f; //! Layer of the image in the array
+	glm::vec4 rect = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f); //! Scale (xy) and offset (zw) of the image within the layer, texture coordinates are wrapped into it
+};
+
+/**
+  Statistics of the texture arrays built last.
+*/
+struct TextureArraysStats
+{
+	uint32_t numImages = 0; //! Images packed
+	uint32_t numArrays = 0; //! Array textures, atlas included
+	uint32_t numLayers = 0; //! Layers of images sharing their size and format
+	uint32_t numAtlasImages = 0; //! Images of odd sizes packed into the atlas
+	uint32_t numAtlasPages = 0; //! Layers of the atlas
+	double buildTimeMs = 0.0; //! Decoding, packing and uploading
+};
+
+/**
+  Material textures packed into few GL_TEXTURE_2D_ARRAY textures, so that objects with different materials bind the same
+  texture and differ only in the layer (and rectangle) they sample - a per draw uniform, or a per instance attribute
+  of instanced batches (TEXTURE_ARRAYS permutation). Images sharing size and format become layers of one array, images
+  of odd sizes are shelf packed into the layers of an RGBA8 atlas, with a gutter of wrapped texels around each of them
+  so that repeating texture coordinates filter across the edge like in a texture of their own. Atlas mipmaps stop
+  before they blend neighbours through the gutter.
+*/
+class TextureArrays
+{
+public:
+	static const int ATLAS_PAGE_SIZE = 2048; //! Width and height of the atlas layers, larger images get an array of their own
+	static const int ATLAS_GUTTER = 8; //! Wrapped texels around every atlas image
+	static const int ATLAS_LEVELS = 4; //! Mip levels of the atlas, the gutter is one texel wide at the last one
+
+	TextureArrays() = default;
+	~TextureArrays();
+
+	TextureArrays(const TextureArrays&) = delete;
+	TextureArrays& operator=(const TextureArrays&) = delete;
+
+	/** \brief Decodes given images (in parallel) and packs them into array textures, replacing the previous ones.
+	*   \param options Wrapping is always repeat, mipmaps and sRGB are taken from the options
+	*/
+	void build(const std::vector<std::string>& paths, const TextureOptions& options = TextureOptions());
+
+	/** \brief Gets slot of the image of given index into the paths the arrays were built from. */
+	const TextureSlot& getSlot(size_t index) const;
+
+	/** \brief Gets sampler object all arrays are sampled with. */
+	GLuint getSampler() const;
+
+	/** \brief Gets statistics of the arrays built last. */
+	const TextureArraysStats& getStats() const;
+
+	/** \brief Prints statistics of the arrays built last in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+	/** \brief Deletes all array textures and the sampler (the OpenGL context must still exist). */
+	void deleteResources();
+
+private:
+	/** Decoded image, pixels are null if decoding failed. */
+	struct Image
+	{
+		unsigned char* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+	};
+
+	std::vector<GLuint> _arrays;
+	std::vector<TextureSlot> _slots; // One per image the arrays were built from
+	GLuint _sampler = 0;
+	TextureArraysStats _stats;
+
+	/** \brief Creates array with one layer per given image, all of them with the same size and format. */
+	void createArray(const std::vector<size_t>& indices, const std::vector<Image>& images, const TextureOptions& options);
+
+	/** \brief Packs given images into the layers of an RGBA8 atlas. */
+	void createAtlas(std::vector<size_t> indices, const std::vector<Image>& images, const TextureOptions& options);
+};
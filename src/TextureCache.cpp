@@ -0,0 +1,132 @@
+// STL
+#include <filesystem>
+#include <functional>
+
+// Project
+#include "BakedTexture.h"
+#include "TextureCache.h"
+
+namespace {
+
+	// The same image may be referred to by relative and absolute paths, or with redundant "." and ".." in them
+	std::string canonicalPath(const char* path)
+	{
+		std::error_code error;
+		const auto canonical = std::filesystem::weakly_canonical(path, error);
+		return error ? std::filesystem::path(path).lexically_normal().generic_string() : canonical.generic_string();
+	}
+
+	int getOptionBits(const TextureOptions& options)
+	{
+		return (options.repeat ? 1 : 0) | (options.mipmaps ? 2 : 0) | (options.srgb ? 4 : 0);
+	}
+
+} // namespace
+
+bool TextureKey::operator==(const TextureKey& other) const
+{
+	return path == other.path && options == other.options;
+}
+
+size_t TextureKeyHash::operator()(const TextureKey& key) const
+{
+	// Combine hashes of all members, same way as boost::hash_combine does
+	size_t seed = 0;
+	const auto combine = [&seed](size_t value) {
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	};
+
+	combine(std::hash<std::string>()(key.path));
+	combine(size_t(getOptionBits(key.options)));
+	return seed;
+}
+
+TextureCache::TextureCache(TextureLoader* loader, TextureStreamer* streamer)
+	: _loader(loader)
+	, _streamer(streamer)
+{
+}
+
+std::shared_ptr<const CachedTexture> TextureCache::getTexture(const char* path, const TextureOptions& options)
+{
+	const TextureKey key{ canonicalPath(path), options };
+
+	auto it = _textures.find(key);
+	if (it != _textures.end())
+	{
+		if (auto texture = it->second.lock())
+		{
+			_stats.hits++;
+			return texture;
+		}
+	}
+
+	// Not cached (or already released), stream or load the baked texture, or decode the image
+	_stats.misses++;
+	const auto texture = new CachedTexture;
+	const auto bakedPath = getBakedTexturePath(path);
+	if (isBakedTextureUpToDate(path, bakedPath))
+	{
+		if (_streamer != nullptr && options.mipmaps && (texture->id = _streamer->load(bakedPath.c_str(), options)) != 0) {
+			_stats.streamedLoads++;
+		}
+		else {
+			texture->id = loadBakedTexture(bakedPath.c_str(), options);
+		}
+		_stats.bakedLoads += texture->id != 0 ? 1 : 0;
+	}
+	if (texture->id == 0) {
+		texture->id = _loader != nullptr ? _loader->request(path, options) : loadTexture(path, options);
+	}
+	texture->path = key.path;
+	auto& sampler = _samplers[getOptionBits(options)];
+	if (sampler == 0)
+	{
+		sampler = createSampler(options);
+		_stats.numSamplers++;
+	}
+	texture->sampler = sampler;
+	_stats.numTextures++;
+
+	std::shared_ptr<const CachedTexture> result(texture, [this, key](const CachedTexture* cached) {
+		_stats.numTextures--;
+
+		// Only forget the entry if nobody has reloaded the texture in the meantime
+		auto entry = _textures.find(key);
+		if (entry != _textures.end() && entry->second.expired()) {
+			_textures.erase(entry);
+		}
+
+		if (_loader != nullptr) {
+			_loader->cancel(cached->id);
+		}
+		if (_streamer != nullptr) {
+			_streamer->release(cached->id);
+		}
+		glDeleteTextures(1, &cached->id);
+		delete cached;
+	});
+
+	_textures[key] = result;
+	return result;
+}
+
+void TextureCache::deleteResources()
+{
+	for (const auto& sampler : _samplers) {
+		glDeleteSamplers(1, &sampler.second);
+	}
+	_samplers.clear();
+	_stats.numSamplers = 0;
+}
+
+const TextureCacheStats& TextureCache::getStats() const
+{
+	return _stats;
+}
+
+void TextureCache::printStats(std::ostream& os) const
+{
+	os << "Texture cache: " << _stats.hits << " hits, " << _stats.misses << " misses (" << _stats.bakedLoads << " baked, " << _stats.streamedLoads << " streamed), "
+		<< _stats.numTextures << " textures alive, " << _stats.numSamplers << " samplers" << std::endl;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+// Project
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+
+/**
+* Key identifying one cached texture - canonical path of its image and the options it is loaded with.
+*/
+struct TextureKey
+{
+	std::string path;
+	TextureOptions options;
+
+	bool operator==(const TextureKey& other) const;
+};
+
+struct TextureKeyHash
+{
+	size_t operator()(const TextureKey& key) const;
+};
+
+/**
+* Texture shared by everything using the same image with the same options, deleted with its last handle.
+*/
+struct CachedTexture
+{
+	GLuint id = 0; //!< OpenGL texture ID
+	GLuint sampler = 0; //!< Sampler object of its options, shared with all textures loaded with them
+	std::string path; //!< Canonical path of the image
+};
+
+/**
+* Counters of the texture cache, so that we can confirm images are decoded and uploaded once.
+*/
+struct TextureCacheStats
+{
+	uint64_t hits = 0; //!< How many requests were served by an already loaded texture
+	uint64_t misses = 0; //!< How many requests had to load a new texture
+	uint64_t bakedLoads = 0; //!< How many of the loads used a baked texture instead of decoding the image
+	uint64_t streamedLoads = 0; //!< How many of the baked loads left the finer levels to the texture streamer
+	size_t numTextures = 0; //!< Number of textures currently alive
+	size_t numSamplers = 0; //!< Number of sampler objects, one per distinct options
+};
+
+/**
+* Registry of 2D textures keyed by canonical image path and load options. Textures are loaded on first request only -
+* from their baked texture if it's up to date (streaming its finer levels if the cache has a streamer), otherwise by decoding
+* the image (in the background if the cache has a loader).
+* Every other request for the same image with the same options gets
+* a shared handle to the same texture, no matter how the path was spelled. Texture is deleted when the last handle
+* goes away, so the cache must outlive all handles it gave out (and the OpenGL context must outlive both).
+*/
+class TextureCache
+{
+public:
+	/** \brief Creates empty cache, loading textures with given loader, or right away if it's null.
+	*   \param streamer Streams mipmapped baked textures, null to load all their levels right away
+	*/
+	explicit TextureCache(TextureLoader* loader = nullptr, TextureStreamer* streamer = nullptr);
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	/** \brief  Gets shared texture of given image with given options, loads it if it does not exist yet.
+	*   \return Reference counted handle to the texture.
+	*/
+	std::shared_ptr<const CachedTexture> getTexture(const char* path, const TextureOptions& options = TextureOptions());
+
+	/** \brief  Deletes the sampler objects (the OpenGL context must still exist), textures go away with their last handle. */
+	void deleteResources();
+
+	/** \brief  Gets cache counters (hits, misses, textures alive). */
+	const TextureCacheStats& getStats() const;
+
+	/** \brief  Prints cache counters in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+private:
+	TextureLoader* _loader;
+	TextureStreamer* _streamer;
+	std::unordered_map<TextureKey, std::weak_ptr<const CachedTexture>, TextureKeyHash> _textures;
+	std::unordered_map<int, GLuint> _samplers; // Keyed by option bits
+	TextureCacheStats _stats;
+};
@@ -0,0 +1,298 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// Project
+#include "GLDebug.h"
+#include "TextureLoader.h"
+#include "TextureStorage.h"
+#include "stb_image.h"
+
+namespace {
+
+	// Decoding threads when the core count is unknown, and at most (decoding is bound by memory long before that)
+	const unsigned int DEFAULT_NUM_THREADS = 2;
+	const unsigned int MAX_NUM_THREADS = 8;
+
+	double elapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+} // namespace
+
+const unsigned char TextureLoader::PLACEHOLDER_COLOR[4] = { 128, 128, 128, 255 };
+
+TextureLoader::~TextureLoader()
+{
+	deleteResources();
+}
+
+void TextureLoader::create(unsigned int numThreads)
+{
+	deleteResources();
+
+	if (numThreads == 0)
+	{
+		const auto numCores = std::thread::hardware_concurrency();
+		numThreads = numCores > 1 ? std::min(numCores - 1, MAX_NUM_THREADS) : DEFAULT_NUM_THREADS;
+	}
+
+	// the flag is global in stb_image, set once before any worker reads it (loadTexture flips the same way)
+	stbi_set_flip_vertically_on_load(true);
+
+	glGenBuffers(1, &_pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBuffer);
+	GL_LABEL(GL_BUFFER, _pixelBuffer, "Texture upload buffer");
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	_stopping = false;
+	for (unsigned int i = 0; i < numThreads; i++) {
+		_workers.emplace_back(&TextureLoader::decodeLoop, this);
+	}
+	_stats = TextureLoaderStats();
+	_stats.numThreads = numThreads;
+}
+
+GLuint TextureLoader::request(const char* path, const TextureOptions& options)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	GL_LABEL(GL_TEXTURE, texture, path);
+	// mutable, so that the image can replace it with storage of its own size
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_COLOR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	_stats.numRequested++;
+
+	if (_workers.empty())
+	{
+		std::cerr << "Texture loader has not been created, " << path << " keeps the placeholder!" << std::endl;
+		_stats.numFailed++;
+		return texture;
+	}
+
+	const auto jobId = ++_nextJobId;
+	_pendingJobs[texture] = jobId;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back({ texture, path, options, jobId });
+	}
+	_jobQueued.notify_one();
+	_numPending++;
+	return texture;
+}
+
+void TextureLoader::cancel(GLuint texture)
+{
+	if (_pendingJobs.erase(texture) == 0) {
+		return;
+	}
+	_stats.numCancelled++;
+
+	// a queued job goes right away, an image being decoded (or decoded already) is dropped when it's taken for upload
+	std::lock_guard<std::mutex> lock(_mutex);
+	const auto job = std::find_if(_jobs.begin(), _jobs.end(), [texture](const Job& queued) { return queued.texture == texture; });
+	if (job != _jobs.end())
+	{
+		_jobs.erase(job);
+		_numPending--;
+	}
+}
+
+void TextureLoader::update(double budgetMs)
+{
+	if (_numPending == 0) {
+		return;
+	}
+	const auto start = std::chrono::steady_clock::now();
+
+	auto numUploads = 0;
+	DecodedImage image;
+	while ((numUploads == 0 || elapsedMs(start) < budgetMs) && popDecodedImage(image))
+	{
+		upload(image);
+		numUploads++;
+	}
+
+	if (numUploads > 0)
+	{
+		const auto updateTime = elapsedMs(start);
+		_stats.numUploadFrames++;
+		_stats.numFramesOverBudget += updateTime > budgetMs ? 1 : 0;
+		_stats.uploadTimeMs += updateTime;
+	}
+}
+
+void TextureLoader::finish()
+{
+	const auto start = std::chrono::steady_clock::now();
+	while (_numPending > 0)
+	{
+		DecodedImage image;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_imageDecoded.wait(lock, [this]() { return !_decodedImages.empty(); });
+			image = _decodedImages.front();
+			_decodedImages.pop_front();
+		}
+		upload(image);
+	}
+	_stats.uploadTimeMs += elapsedMs(start);
+}
+
+bool TextureLoader::isIdle() const
+{
+	return _numPending == 0;
+}
+
+const TextureLoaderStats& TextureLoader::getStats() const
+{
+	return _stats;
+}
+
+void TextureLoader::printStats(std::ostream& os) const
+{
+	os << "Texture loader: " << _stats.numUploaded << " of " << _stats.numRequested << " textures uploaded (" << _stats.numFailed << " failed, "
+		<< _stats.numCancelled << " cancelled) by "
+		<< _stats.numThreads << " threads, " << _stats.bytesUploaded / 1024 << " KiB, decoded in " << _stats.decodeTimeMs << " ms, uploaded in "
+		<< _stats.uploadTimeMs << " ms over " << _stats.numUploadFrames << " frames (" << _stats.numFramesOverBudget << " over budget)" << std::endl;
+}
+
+void TextureLoader::deleteResources()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_jobQueued.notify_all();
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+
+	// textures not uploaded yet keep their placeholder
+	_jobs.clear();
+	for (auto& image : _decodedImages) {
+		stbi_image_free(image.pixels);
+	}
+	_decodedImages.clear();
+	_pendingJobs.clear();
+	_numPending = 0;
+
+	if (_pixelBuffer != 0)
+	{
+		glDeleteBuffers(1, &_pixelBuffer);
+		_pixelBuffer = 0;
+	}
+}
+
+void TextureLoader::decodeLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_jobQueued.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+			if (_stopping) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		DecodedImage image = { job.texture, std::move(job.path), nullptr, 0, 0, 0, job.options, 0.0, job.id };
+		image.pixels = stbi_load(image.path.c_str(), &image.width, &image.height, &image.channels, 0);
+		image.decodeTimeMs = elapsedMs(start);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_decodedImages.push_back(std::move(image));
+		}
+		_imageDecoded.notify_one();
+	}
+}
+
+bool TextureLoader::popDecodedImage(DecodedImage& image)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_decodedImages.empty()) {
+		return false;
+	}
+	image = _decodedImages.front();
+	_decodedImages.pop_front();
+	return true;
+}
+
+void TextureLoader::upload(DecodedImage& image)
+{
+	_numPending--;
+	_stats.decodeTimeMs += image.decodeTimeMs;
+
+	// the owner may have cancelled the texture in the meantime, its name may even belong to another request by now
+	const auto job = _pendingJobs.find(image.texture);
+	if (job == _pendingJobs.end() || job->second != image.jobId)
+	{
+		stbi_image_free(image.pixels);
+		return;
+	}
+	_pendingJobs.erase(job);
+
+	if (image.pixels == nullptr)
+	{
+		std::cout << "Texture failed to load at path: " << image.path << std::endl;
+		_stats.numFailed++;
+		return;
+	}
+
+	// Storage of the whole mip chain replaces the placeholder, allocated before the pixel buffer is bound
+	const auto numLevels = image.options.mipmaps ? TextureStorage::getNumLevels(image.width, image.height) : 1;
+	glBindTexture(GL_TEXTURE_2D, image.texture);
+	TextureStorage::allocate(TextureStorage::getInternalFormat(image.channels, image.options.srgb), image.width, image.height, numLevels);
+	TextureStorage::setSwizzle(GL_TEXTURE_2D, image.channels);
+	// the placeholder clamped the chain to its single level, immutable storage does not reset that
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+
+	// Orphaning gives the driver fresh storage, so that copying never waits for the previous upload to be consumed,
+	// and the texture is then filled from the buffer without the driver copying client memory
+	const auto size = GLsizeiptr(image.width) * image.height * image.channels;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	auto* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	const void* source = nullptr; // offset into the pixel buffer
+	if (mapped != nullptr)
+	{
+		memcpy(mapped, image.pixels, size_t(size));
+		if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+			mapped = nullptr;
+		}
+	}
+	if (mapped == nullptr)
+	{
+		// mapping failed or the buffer got corrupted, pixels go straight from client memory
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		source = image.pixels;
+	}
+
+	// rows of 1 and 3 channel images are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, TextureStorage::getPixelFormat(image.channels), GL_UNSIGNED_BYTE, source);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// unbound, so that later uploads with null data are not read from it
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	if (numLevels > 1) {
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	stbi_image_free(image.pixels);
+	image.pixels = nullptr;
+	_stats.numUploaded++;
+	_stats.bytesUploaded += uint64_t(size);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+// STL
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Project
+#include "Texture.h"
+
+/**
+  Statistics of the texture loader, over the whole run.
+*/
+struct TextureLoaderStats
+{
+	uint32_t numThreads = 0; //! Decoding threads
+	uint32_t numRequested = 0; //! Textures requested
+	uint32_t numUploaded = 0; //! Textures decoded and uploaded
+	uint32_t numFailed = 0; //! Textures whose image could not be decoded, they keep the placeholder
+	uint32_t numCancelled = 0; //! Textures deleted by their owner before their image was uploaded
+	uint64_t bytesUploaded = 0; //! Pixel data streamed through the pixel buffer (level 0 only)
+	uint32_t numUploadFrames = 0; //! Updates that uploaded at least one texture
+	uint32_t numFramesOverBudget = 0; //! Updates that took longer than their budget (a single texture always gets uploaded)
+	double decodeTimeMs = 0.0; //! Decoding time summed over all threads
+	double uploadTimeMs = 0.0; //! Time spent uploading on the OpenGL thread
+};
+
+/**
+  Asynchronous texture loading - images are decoded by a pool of worker threads, decoded ones are streamed into their textures
+  through a pixel buffer object on the OpenGL thread, as many per frame as fit into a time budget. Requested textures
+  get their name at once, holding a 1x1 placeholder until the image replaces it, so that draws can be recorded with them
+  right away and the first frame does not wait for any image.
+*/
+class TextureLoader
+{
+public:
+	static const unsigned char PLACEHOLDER_COLOR[4]; //! Color of the textures still being loaded (neutral grey)
+
+	TextureLoader() = default;
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	/** \brief Starts the worker threads and creates the pixel buffer.
+	*   \param numThreads Number of decoding threads, 0 to use all cores but the one running OpenGL
+	*/
+	void create(unsigned int numThreads = 0);
+
+	/** \brief Creates a 2D texture with given options holding the placeholder and queues decoding of the image file into it.
+	*   \return OpenGL texture ID, owned by the caller (who must cancel it before deleting it), the placeholder stays if the image could not be loaded.
+	*/
+	GLuint request(const char* path, const TextureOptions& options = TextureOptions());
+
+	/** \brief Stops loading into the texture, called right before it's deleted. Textures already uploaded (or unknown) are ignored. */
+	void cancel(GLuint texture);
+
+	/** \brief Uploads decoded images until given time budget is used up (at least one, if any is ready). Never waits for decoding. */
+	void update(double budgetMs);
+
+	/** \brief Waits for all requested images and uploads them, for runs that must render the final textures from the first frame. */
+	void finish();
+
+	/** \brief Checks, if all requested textures have been uploaded (or failed). */
+	bool isIdle() const;
+
+	/** \brief Gets statistics of all loads so far. */
+	const TextureLoaderStats& getStats() const;
+
+	/** \brief Prints statistics of all loads so far in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+	/** \brief Stops the workers, drops images not uploaded yet and deletes the pixel buffer (the OpenGL context must still exist).
+	*   Requested textures are not deleted, they belong to the caller.
+	*/
+	void deleteResources();
+
+private:
+	/** Image to be decoded into a texture. */
+	struct Job
+	{
+		GLuint texture;
+		std::string path;
+		TextureOptions options;
+		uint64_t id; // Tells this request from later ones into a texture of the same name
+	};
+
+	/** Decoded image waiting for upload, pixels are null if decoding failed. */
+	struct DecodedImage
+	{
+		GLuint texture;
+		std::string path;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+		TextureOptions options;
+		double decodeTimeMs;
+		uint64_t jobId;
+	};
+
+	std::vector<std::thread> _workers;
+	std::mutex _mutex; // Guards both queues and the stop flag
+	std::condition_variable _jobQueued; // Wakes workers
+	std::condition_variable _imageDecoded; // Wakes finish()
+	std::deque<Job> _jobs;
+	std::deque<DecodedImage> _decodedImages;
+	bool _stopping = false;
+
+	uint32_t _numPending = 0; // Requested textures not uploaded yet (OpenGL thread only)
+	std::unordered_map<GLuint, uint64_t> _pendingJobs; // Job each texture waits for, cancelled ones are missing (OpenGL thread only)
+	uint64_t _nextJobId = 0;
+	GLuint _pixelBuffer = 0; // Staging buffer of the uploads, orphaned by each of them
+	TextureLoaderStats _stats;
+
+	/** \brief Decodes queued images until the loader stops. */
+	void decodeLoop();
+
+	/** \brief Takes the oldest decoded image, if there is any. */
+	bool popDecodedImage(DecodedImage& image);
+
+	/** \brief Uploads the decoded image into its texture, generates its mipmaps and frees the pixels. */
+	void upload(DecodedImage& image);
+};
@@ -0,0 +1,135 @@
+// STL
+#include <algorithm>
+#include <iostream>
+
+// Project
+#include "GLExtensions.h"
+#include "TextureStorage.h"
+
+namespace {
+
+	// Pixel format matching an uncompressed sized format, needed to specify levels without immutable storage
+	GLenum getPixelFormatOf(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_R8: return GL_RED;
+		case GL_RG8: return GL_RG;
+		case GL_RGB8:
+		case GL_SRGB8: return GL_RGB;
+		default: return GL_RGBA;
+		}
+	}
+
+} // namespace
+
+bool TextureStorage::_isImmutable = false;
+bool TextureStorage::_isS3TCAvailable = false;
+
+bool TextureStorage::initialize(GLADloadproc load)
+{
+	_isS3TCAvailable = hasGLExtension("GL_EXT_texture_compression_s3tc");
+
+	// Functions are core since 4.2, glad loads no extensions, so with GL_ARB_texture_storage on older context we load them ourselves
+	_isImmutable = GLAD_GL_VERSION_4_2 != 0;
+	if (!_isImmutable && hasGLExtension("GL_ARB_texture_storage"))
+	{
+		glad_glTexStorage2D = reinterpret_cast<PFNGLTEXSTORAGE2DPROC>(load("glTexStorage2D"));
+		glad_glTexStorage3D = reinterpret_cast<PFNGLTEXSTORAGE3DPROC>(load("glTexStorage3D"));
+		_isImmutable = glad_glTexStorage2D != nullptr && glad_glTexStorage3D != nullptr;
+	}
+
+	if (!_isImmutable)
+	{
+		std::cout << "GL_ARB_texture_storage is not available, textures get mutable storage" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool TextureStorage::isImmutable()
+{
+	return _isImmutable;
+}
+
+bool TextureStorage::isS3TCAvailable()
+{
+	return _isS3TCAvailable;
+}
+
+GLenum TextureStorage::getInternalFormat(int channels, bool srgb)
+{
+	switch (channels)
+	{
+	case 1: return GL_R8;
+	case 2: return GL_RG8;
+	case 3: return srgb ? GL_SRGB8 : GL_RGB8;
+	default: return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	}
+}
+
+GLenum TextureStorage::getPixelFormat(int channels)
+{
+	switch (channels)
+	{
+	case 1: return GL_RED;
+	case 2: return GL_RG;
+	case 3: return GL_RGB;
+	default: return GL_RGBA;
+	}
+}
+
+void TextureStorage::setSwizzle(GLenum target, int channels)
+{
+	// stb_image gives grey and alpha, which RG8 would read as red and green
+	static const GLint GREY_ALPHA[4] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+	if (channels == 2) {
+		glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, GREY_ALPHA);
+	}
+}
+
+GLsizei TextureStorage::getNumLevels(GLsizei width, GLsizei height)
+{
+	GLsizei numLevels = 1;
+	for (auto size = std::max(width, height); size > 1; size /= 2) {
+		numLevels++;
+	}
+	return numLevels;
+}
+
+void TextureStorage::allocate(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei numLevels)
+{
+	if (_isImmutable)
+	{
+		glTexStorage2D(GL_TEXTURE_2D, numLevels, internalFormat, width, height);
+		return;
+	}
+
+	const auto format = getPixelFormatOf(internalFormat);
+	for (GLsizei level = 0; level < numLevels; level++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, GLint(internalFormat), width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+}
+
+void TextureStorage::allocateArray(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei numLayers, GLsizei numLevels)
+{
+	if (_isImmutable)
+	{
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, numLevels, internalFormat, width, height, numLayers);
+		return;
+	}
+
+	// layers keep their count at every level, only width and height shrink
+	const auto format = getPixelFormatOf(internalFormat);
+	for (GLsizei level = 0; level < numLevels; level++)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GLint(internalFormat), width, height, numLayers, 0, format, GL_UNSIGNED_BYTE, nullptr);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+}
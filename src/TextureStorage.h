@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// EXT_texture_compression_s3tc (and its sRGB variants from EXT_texture_sRGB) are not part of the core profile glad has been generated for
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+/*
+  Storage of 2D textures - sized internal formats and the whole mip chain allocated up front, so that the layout
+  (and VRAM use) does not depend on what the driver guesses from unsized formats. With OpenGL 4.2 or
+  GL_ARB_texture_storage the storage is immutable (glTexStorage2D) and the driver validates it once instead of on every bind.
+  Without it, every level is specified with glTexImage2D in the same sized format and GL_TEXTURE_MAX_LEVEL ends the chain.
+*/
+class TextureStorage
+{
+public:
+	/** \brief Looks for immutable storage and S3TC support, call right after glad has been loaded.
+	*   \param load Loader given to glad, used to get GL_ARB_texture_storage entry points on contexts older than 4.2
+	*   \return True if the storage is immutable, false otherwise.
+	*/
+	static bool initialize(GLADloadproc load);
+
+	/** \brief Checks, if textures get immutable storage. */
+	static bool isImmutable();
+
+	/** \brief Checks, if S3TC (BC1..BC3) compressed textures can be used. */
+	static bool isS3TCAvailable();
+
+	/** \brief Gets sized internal format for an image with given number of 8-bit channels (R8, RG8, RGB8 or RGBA8, color ones optionally sRGB). */
+	static GLenum getInternalFormat(int channels, bool srgb);
+
+	/** \brief Gets pixel format of an image with given number of channels. */
+	static GLenum getPixelFormat(int channels);
+
+	/** \brief Makes the texture bound to given target read a grey and alpha image (2 channels, stored as RG8) as grey RGB with alpha.
+	*   Images with other numbers of channels keep the default swizzle.
+	*/
+	static void setSwizzle(GLenum target, int channels);
+
+	/** \brief Gets number of levels of a full mip chain down to 1x1. */
+	static GLsizei getNumLevels(GLsizei width, GLsizei height);
+
+	/** \brief Allocates levels of the texture bound to GL_TEXTURE_2D with an uncompressed sized format (or any format, if the storage is immutable).
+	*   No pixel unpack buffer may be bound, the contents are undefined until uploaded with glTexSubImage2D.
+	*/
+	static void allocate(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei numLevels);
+
+	/** \brief Allocates levels of all layers of the texture bound to GL_TEXTURE_2D_ARRAY with an uncompressed sized format, same as allocate. */
+	static void allocateArray(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei numLayers, GLsizei numLevels);
+
+private:
+	static bool _isImmutable; //! Flag telling, if glTexStorage2D and glTexStorage3D can be called
+	static bool _isS3TCAvailable; //! Flag telling, if the driver exposes GL_EXT_texture_compression_s3tc
+};
@@ -0,0 +1,286 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+// Project
+#include "GLDebug.h"
+#include "TextureStorage.h"
+#include "TextureStreamer.h"
+
+namespace {
+
+	double elapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+} // namespace
+
+TextureStreamer::~TextureStreamer()
+{
+	deleteResources();
+}
+
+void TextureStreamer::create(uint64_t budgetBytes)
+{
+	deleteResources();
+	_frame = 0;
+	_stats = TextureStreamerStats();
+	_stats.budgetBytes = budgetBytes;
+}
+
+GLuint TextureStreamer::load(const char* bakedPath, const TextureOptions& options)
+{
+	if (!TextureStorage::isS3TCAvailable()) {
+		return 0;
+	}
+
+	StreamedTexture texture;
+	texture.file.reset(new MappedFile);
+	if (!texture.file->open(bakedPath) || (texture.internalFormat = readBakedTexture(*texture.file, bakedPath, options, texture.levels)) == 0) {
+		return 0;
+	}
+
+	// the small levels are what every texture starts (and ends) with
+	const auto numLevels = GLint(texture.levels.size());
+	texture.smallLevel = 0;
+	while (texture.smallLevel < numLevels - 1
+		&& std::max(texture.levels[texture.smallLevel].width, texture.levels[texture.smallLevel].height) > RESIDENT_SIZE) {
+		texture.smallLevel++;
+	}
+	texture.residentLevel = texture.smallLevel;
+	texture.neededLevel = texture.smallLevel;
+
+	GLuint name;
+	glGenTextures(1, &name);
+	glBindTexture(GL_TEXTURE_2D, name);
+	GL_LABEL(GL_TEXTURE, name, bakedPath);
+	for (auto level = texture.smallLevel; level < numLevels; level++)
+	{
+		const auto& blocks = texture.levels[level];
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat, blocks.width, blocks.height, 0, blocks.size, blocks.blocks);
+		_stats.residentBytes += uint64_t(blocks.size);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.smallLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	for (const auto& blocks : texture.levels) {
+		_stats.fullBytes += uint64_t(blocks.size);
+	}
+	_stats.peakResidentBytes = std::max(_stats.peakResidentBytes, _stats.residentBytes);
+	_stats.numTextures++;
+	_textures.emplace(name, std::move(texture));
+	return name;
+}
+
+void TextureStreamer::release(GLuint texture)
+{
+	const auto it = _textures.find(texture);
+	if (it == _textures.end()) {
+		return;
+	}
+
+	const auto& levels = it->second.levels;
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		_stats.fullBytes -= uint64_t(levels[level].size);
+		if (GLint(level) >= it->second.residentLevel) {
+			_stats.residentBytes -= uint64_t(levels[level].size);
+		}
+	}
+	_stats.numTextures--;
+	_textures.erase(it);
+}
+
+void TextureStreamer::beginFrame()
+{
+	_frame++;
+	for (auto& texture : _textures) {
+		texture.second.neededLevel = texture.second.smallLevel;
+	}
+}
+
+void TextureStreamer::request(GLuint texture, float screenSize)
+{
+	const auto it = _textures.find(texture);
+	if (it == _textures.end()) {
+		return;
+	}
+
+	// every level halves the texels, the finer of the two levels around the exact one keeps the texture sharp
+	auto& streamed = it->second;
+	const auto size = float(std::max(streamed.levels[0].width, streamed.levels[0].height));
+	const auto level = screenSize > 0.0f ? std::floor(std::log2(size / screenSize)) : float(streamed.smallLevel);
+	streamed.neededLevel = std::min(streamed.neededLevel, GLint(std::min(std::max(level, 0.0f), float(streamed.smallLevel))));
+	streamed.lastUsedFrame = _frame;
+}
+
+void TextureStreamer::update(double budgetMs)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	// textures lacking the most levels go first
+	std::vector<std::pair<GLint, GLuint>> lacking;
+	for (auto& texture : _textures)
+	{
+		auto& streamed = texture.second;
+		if (streamed.neededLevel < streamed.residentLevel)
+		{
+			if (!streamed.waiting)
+			{
+				streamed.waiting = true;
+				streamed.requestTime = start;
+			}
+			lacking.emplace_back(streamed.residentLevel - streamed.neededLevel, texture.first);
+		}
+		else {
+			streamed.waiting = false;
+		}
+	}
+	if (lacking.empty()) {
+		return;
+	}
+	std::sort(lacking.begin(), lacking.end(), [](const std::pair<GLint, GLuint>& a, const std::pair<GLint, GLuint>& b) {
+		return a.first != b.first ? a.first > b.first : a.second < b.second;
+	});
+
+	// one level per texture and pass, so that a single large texture does not hold the others back
+	auto numUploads = 0;
+	auto stalled = false;
+	auto progress = true;
+	while (progress && (numUploads == 0 || elapsedMs(start) < budgetMs))
+	{
+		progress = false;
+		for (const auto& entry : lacking)
+		{
+			if (numUploads > 0 && elapsedMs(start) >= budgetMs) {
+				break;
+			}
+			auto& streamed = _textures[entry.second];
+			if (streamed.residentLevel <= streamed.neededLevel) {
+				continue;
+			}
+			if (!streamIn(entry.second, streamed))
+			{
+				stalled = true;
+				continue;
+			}
+			numUploads++;
+			progress = true;
+		}
+	}
+
+	_stats.numBudgetStalls += stalled ? 1 : 0;
+	_stats.numFullyResident = 0;
+	for (const auto& texture : _textures) {
+		_stats.numFullyResident += texture.second.residentLevel == 0 ? 1 : 0;
+	}
+	_stats.uploadTimeMs += elapsedMs(start);
+}
+
+void TextureStreamer::finish()
+{
+	update(std::numeric_limits<double>::infinity());
+}
+
+const TextureStreamerStats& TextureStreamer::getStats() const
+{
+	return _stats;
+}
+
+void TextureStreamer::printStats(std::ostream& os) const
+{
+	const auto averageLatencyMs = _stats.numStreamIns > 0 ? _stats.totalLatencyMs / _stats.numStreamIns : 0.0;
+	os << "Texture streamer: " << _stats.residentBytes / 1024 << " of " << _stats.fullBytes / 1024 << " KiB resident (peak "
+		<< _stats.peakResidentBytes / 1024 << " KiB, budget " << _stats.budgetBytes / 1024 << " KiB), " << _stats.numFullyResident << " of "
+		<< _stats.numTextures << " textures fully resident, " << _stats.numLevelsStreamedIn << " levels streamed in ("
+		<< _stats.bytesStreamedIn / 1024 << " KiB), " << _stats.numLevelsEvicted << " evicted, " << _stats.numBudgetStalls
+		<< " budget stalls, stream-in latency " << averageLatencyMs << " ms average, " << _stats.maxLatencyMs << " ms max, "
+		<< _stats.uploadTimeMs << " ms uploading" << std::endl;
+}
+
+void TextureStreamer::deleteResources()
+{
+	_textures.clear();
+	_stats.numTextures = 0;
+	_stats.numFullyResident = 0;
+	_stats.residentBytes = 0;
+	_stats.fullBytes = 0;
+}
+
+bool TextureStreamer::streamIn(GLuint name, StreamedTexture& texture)
+{
+	const auto level = texture.residentLevel - 1;
+	const auto& blocks = texture.levels[level];
+	if (!makeRoom(uint64_t(blocks.size))) {
+		return false;
+	}
+
+	// the level is complete before the base level moves onto it
+	glBindTexture(GL_TEXTURE_2D, name);
+	glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat, blocks.width, blocks.height, 0, blocks.size, blocks.blocks);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	texture.residentLevel = level;
+
+	_stats.residentBytes += uint64_t(blocks.size);
+	_stats.peakResidentBytes = std::max(_stats.peakResidentBytes, _stats.residentBytes);
+	_stats.bytesStreamedIn += uint64_t(blocks.size);
+	_stats.numLevelsStreamedIn++;
+	if (texture.waiting && texture.residentLevel <= texture.neededLevel)
+	{
+		const auto latencyMs = elapsedMs(texture.requestTime);
+		texture.waiting = false;
+		_stats.numStreamIns++;
+		_stats.totalLatencyMs += latencyMs;
+		_stats.maxLatencyMs = std::max(_stats.maxLatencyMs, latencyMs);
+	}
+	return true;
+}
+
+bool TextureStreamer::makeRoom(uint64_t bytes)
+{
+	if (_stats.residentBytes + bytes <= _stats.budgetBytes) {
+		return true;
+	}
+
+	// only levels finer than needed this frame can go, textures not requested this frame need their small levels only
+	std::vector<std::pair<uint64_t, GLuint>> candidates;
+	for (const auto& texture : _textures)
+	{
+		if (texture.second.residentLevel < texture.second.neededLevel) {
+			candidates.emplace_back(texture.second.lastUsedFrame, texture.first);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	for (const auto& candidate : candidates)
+	{
+		auto& texture = _textures[candidate.second];
+		while (texture.residentLevel < texture.neededLevel && _stats.residentBytes + bytes > _stats.budgetBytes) {
+			evict(candidate.second, texture);
+		}
+		if (_stats.residentBytes + bytes <= _stats.budgetBytes) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void TextureStreamer::evict(GLuint name, StreamedTexture& texture)
+{
+	// the base level moves off the level first, then its storage is given back by respecifying it empty
+	const auto level = texture.residentLevel;
+	glBindTexture(GL_TEXTURE_2D, name);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat, 0, 0, 0, 0, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	texture.residentLevel = level + 1;
+
+	_stats.residentBytes -= uint64_t(texture.levels[level].size);
+	_stats.numLevelsEvicted++;
+}
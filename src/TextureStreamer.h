@@ -0,0 +1,123 @@
+#pragma once
+
+// STL
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Project
+#include "BakedTexture.h"
+#include "MappedFile.h"
+#include "Texture.h"
+
+/**
+  Statistics of the texture streamer, residency is the current one, counters are over the whole run.
+*/
+struct TextureStreamerStats
+{
+	uint32_t numTextures = 0; //! Streamed textures alive
+	uint32_t numFullyResident = 0; //! Streamed textures with all their levels resident
+	uint64_t budgetBytes = 0; //! Residency budget
+	uint64_t residentBytes = 0; //! Levels resident now, the always resident small ones included
+	uint64_t peakResidentBytes = 0; //! Most levels that have been resident at once
+	uint64_t fullBytes = 0; //! Levels there would be resident without streaming
+	uint64_t bytesStreamedIn = 0; //! Blocks uploaded by stream-ins
+	uint32_t numLevelsStreamedIn = 0; //! Levels uploaded after load
+	uint32_t numLevelsEvicted = 0; //! Levels dropped to make room for others
+	uint32_t numBudgetStalls = 0; //! Updates that left a needed level out, the budget being full of needed levels
+	uint32_t numStreamIns = 0; //! Textures that got all the levels they needed, each counted once per need
+	double totalLatencyMs = 0.0; //! Time from textures needing finer levels to having them all, summed over all stream-ins
+	double maxLatencyMs = 0.0; //! Longest of those times
+	double uploadTimeMs = 0.0; //! Time spent streaming in and evicting on the OpenGL thread
+};
+
+/**
+  Mip level streaming of baked textures under a residency budget. A streamed texture is loaded with its small levels only,
+  every frame the scene tells which level each texture needs (from the size its objects cover on screen) and finer levels
+  are streamed in from the mapped baked file, a time budgeted number of them per frame. When the levels would not fit into
+  the budget, levels finer than what their textures need this frame are evicted, least recently used textures first.
+  The storage is mutable, so that evicted levels can be given back - the texture name stays, so recorded draws stay valid,
+  only GL_TEXTURE_BASE_LEVEL moves.
+*/
+class TextureStreamer
+{
+public:
+	static const GLsizei RESIDENT_SIZE = 64; //! Levels this large and smaller are loaded right away and never evicted
+
+	TextureStreamer() = default;
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	/** \brief Sets the residency budget, forgetting all streamed textures. */
+	void create(uint64_t budgetBytes);
+
+	/** \brief Loads small levels of the baked texture into a new texture, the finer ones are streamed in when requested.
+	*   \return OpenGL texture ID, owned by the caller (who must release it before deleting it), 0 if the file is not a valid baked texture.
+	*/
+	GLuint load(const char* bakedPath, const TextureOptions& options);
+
+	/** \brief Stops streaming the texture, called right before it's deleted. Unknown textures are ignored. */
+	void release(GLuint texture);
+
+	/** \brief Starts a frame - all textures are needed at their small levels only, until requested otherwise. */
+	void beginFrame();
+
+	/** \brief Requests level of the texture which maps its larger side onto given number of pixels (the finest request of the frame wins).
+	*   Unknown textures (not streamed) are ignored.
+	*/
+	void request(GLuint texture, float screenSize);
+
+	/** \brief Streams in requested levels until given time budget is used up (at least one, if any is needed and fits). */
+	void update(double budgetMs);
+
+	/** \brief Streams in all requested levels that fit, for runs that must render the final textures from the first frame. */
+	void finish();
+
+	/** \brief Gets statistics of streaming so far. */
+	const TextureStreamerStats& getStats() const;
+
+	/** \brief Prints statistics of streaming so far in a human readable form. */
+	void printStats(std::ostream& os) const;
+
+	/** \brief Forgets all streamed textures and unmaps their files. Textures are not deleted, they belong to the caller. */
+	void deleteResources();
+
+private:
+	/** Streamed texture, resident are the levels from residentLevel to the coarsest one. */
+	struct StreamedTexture
+	{
+		std::unique_ptr<MappedFile> file; // Source of the levels
+		std::vector<BakedTextureLevel> levels; // Blocks of all levels in the file, finest first
+		GLenum internalFormat = 0;
+		GLint residentLevel = 0; // Finest resident level (GL_TEXTURE_BASE_LEVEL)
+		GLint smallLevel = 0; // Finest level never evicted
+		GLint neededLevel = 0; // Finest level requested this frame
+		uint64_t lastUsedFrame = 0; // Frame of the last request
+		bool waiting = false; // Needs finer levels than resident since requestTime
+		std::chrono::steady_clock::time_point requestTime;
+	};
+
+	std::unordered_map<GLuint, StreamedTexture> _textures;
+	uint64_t _frame = 0;
+	TextureStreamerStats _stats;
+
+	/** \brief Uploads the next finer level of the texture, evicting others if it does not fit.
+	*   \return True if the level has been uploaded, false if there's no room for it.
+	*/
+	bool streamIn(GLuint name, StreamedTexture& texture);
+
+	/** \brief Evicts levels not needed this frame, least recently used textures first, until given number of bytes fits into the budget.
+	*   \return True if the bytes fit.
+	*/
+	bool makeRoom(uint64_t bytes);
+
+	/** \brief Drops finest resident level of the texture. */
+	void evict(GLuint name, StreamedTexture& texture);
+};
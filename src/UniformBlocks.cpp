@@ -0,0 +1,64 @@
+// STL
+#include <cstring>
+
+// Project
+#include "GLDebug.h"
+#include "UniformBlocks.h"
+
+UniformBuffer::~UniformBuffer()
+{
+	deleteBuffer();
+}
+
+void UniformBuffer::create(const char* blockName, GLuint binding, size_t byteSize)
+{
+	deleteBuffer();
+
+	_binding = binding;
+	_shadow.assign(byteSize, 0);
+	glGenBuffers(1, &_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+	glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(byteSize), nullptr, GL_DYNAMIC_DRAW);
+	GL_LABEL(GL_BUFFER, _buffer, blockName);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, _buffer);
+}
+
+bool UniformBuffer::update(const void* data)
+{
+	if (_hasData && memcmp(_shadow.data(), data, _shadow.size()) == 0)
+	{
+		_numSkippedUploads++;
+		return false;
+	}
+
+	memcpy(_shadow.data(), data, _shadow.size());
+	_hasData = true;
+	_numUploads++;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, GLsizeiptr(_shadow.size()), _shadow.data());
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return true;
+}
+
+void UniformBuffer::deleteBuffer()
+{
+	if (_buffer != 0)
+	{
+		glDeleteBuffers(1, &_buffer);
+		_buffer = 0;
+	}
+	_shadow.clear();
+	_hasData = false;
+}
+
+size_t UniformBuffer::getNumUploads() const
+{
+	return _numUploads;
+}
+
+size_t UniformBuffer::getNumSkippedUploads() const
+{
+	return _numSkippedUploads;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <glad/glad.h>
+
+/*
+  std140 uniform blocks shared by all programs. Every program declaring a block gets it bound to the same
+  binding point (Shader::bindUniformBlock), so one buffer upload serves all programs and objects.
+  Structures below mirror the GLSL declarations byte for byte, keep them in sync with the shaders.
+*/
+
+// Lights the LightData block holds, NR_POINT_LIGHTS of every permutation of multiple_lights.fs is at most this
+const unsigned int MAX_POINT_LIGHTS = 16;
+
+// Must match size of objectLights in multiple_lights.fs (lights per object with LIGHT_CULLING), all lights LightData holds fit
+const unsigned int MAX_LIGHTS_PER_OBJECT = MAX_POINT_LIGHTS;
+
+// Must match size of shadowLights in multiple_lights.fs (the first lights of the scene cast shadows)
+const unsigned int MAX_SHADOWED_LIGHTS = 4;
+
+enum UniformBlockBinding
+{
+	FRAME_BLOCK_BINDING = 0, //! "FrameData" block - camera of the frame
+	LIGHT_BLOCK_BINDING = 1, //! "LightData" block - point lights
+	CLUSTER_BLOCK_BINDING = 2, //! "ClusterData" block - froxel grid of clustered lighting
+	SHADOW_BLOCK_BINDING = 3 //! "ShadowData" block - shadow cube faces in the shadow atlas
+};
+
+/** Camera of the frame ("FrameData" block). */
+struct FrameBlock
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec4 viewPos; //! Camera position, w unused
+};
+
+/** One point light, scalars fill the padding after each vec3. */
+struct PointLightBlock
+{
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	float padding;
+};
+
+/** All point lights ("LightData" block). */
+struct LightBlock
+{
+	PointLightBlock pointLights[MAX_POINT_LIGHTS];
+};
+
+/** Froxel grid of clustered lighting ("ClusterData" block), see ClusteredLighting. */
+struct ClusterBlock
+{
+	glm::uvec4 gridSize; //! Tiles in x, y, depth slices, number of lights
+	glm::vec4 gridScale; //! Tiles per pixel in x, y, depth slice = log(depth) * z + w
+};
+
+/** Shadows of point lights ("ShadowData" block), see ShadowMaps. */
+struct ShadowBlock
+{
+	glm::vec4 lights[MAX_SHADOWED_LIGHTS]; //! Near plane, far plane, 1 if the light casts shadows (0 otherwise), unused
+	glm::vec4 atlasLayout; //! Size of one cube face in texels, rows of faces (one per shadowed light), unused
+};
+
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock does not match std140 layout of FrameData");
+static_assert(sizeof(PointLightBlock) == 64, "PointLightBlock does not match std140 layout of PointLight");
+static_assert(sizeof(ClusterBlock) == 32, "ClusterBlock does not match std140 layout of ClusterData");
+static_assert(sizeof(ShadowBlock) == 16 * (MAX_SHADOWED_LIGHTS + 1), "ShadowBlock does not match std140 layout of ShadowData");
+
+/**
+  Uniform buffer bound to a binding point, uploaded only when its contents really change.
+*/
+class UniformBuffer
+{
+public:
+	UniformBuffer() = default;
+	~UniformBuffer();
+
+	UniformBuffer(const UniformBuffer&) = delete;
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+	/** \brief Creates buffer of given size and binds it to the binding point.
+	*   \param blockName Name of the GLSL block the buffer backs (used as debug label)
+	*/
+	void create(const char* blockName, GLuint binding, size_t byteSize);
+
+	/** \brief Uploads the data, if they differ from the last uploaded ones.
+	*   \return True if the buffer has been uploaded, false if it already had the data.
+	*/
+	bool update(const void* data);
+
+	/** \brief Deletes the buffer. */
+	void deleteBuffer();
+
+	/** \brief Gets how many times the buffer has been uploaded. */
+	size_t getNumUploads() const;
+
+	/** \brief Gets how many updates have been skipped because the data did not change. */
+	size_t getNumSkippedUploads() const;
+
+private:
+	GLuint _buffer = 0; //! Buffer object ID
+	GLuint _binding = 0; //! Binding point the buffer is bound to
+	std::vector<unsigned char> _shadow; //! Copy of the uploaded data
+	bool _hasData = false; //! Flag telling, if anything has been uploaded yet
+	size_t _numUploads = 0;
+	size_t _numSkippedUploads = 0;
+};
@@ -14,6 +14,33 @@ StaticMeshIndexed3D::~StaticMeshIndexed3D()
     }
 }
 
+int StaticMeshIndexed3D::getNumIndices() const
+{
+    return _numIndices;
+}
+
+int StaticMeshIndexed3D::getPrimitiveRestartIndex() const
+{
+    return _primitiveRestartIndex;
+}
+
+GLuint StaticMeshIndexed3D::createSharedVAO() const
+{
+    if (!_isInitialized) {
+        return 0;
+    }
+
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo.getBufferID());
+    setVertexAttributesPointers(_numVertices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indicesVBO.getBufferID());
+
+    return vao;
+}
+
 void StaticMeshIndexed3D::deleteMesh()
 {
     if (_isInitialized) {
@@ -15,6 +15,18 @@ namespace static_meshes_3D {
 
 		void deleteMesh() override;
 
+		/** \brief  Gets the number of indices used for rendering. */
+		int getNumIndices() const;
+
+		/** \brief  Gets index of primitive restart. */
+		int getPrimitiveRestartIndex() const;
+
+		/** \brief  Creates a new VAO sourcing vertex and index buffers of this mesh, so that
+		*           the mesh data can be combined with other attributes (e.g. per-instance data).
+		*   \return VAO ID owned by the caller, or 0 if mesh is not initialized.
+		*/
+		GLuint createSharedVAO() const;
+
 	protected:
 		VertexBufferObject _indicesVBO; //!< Our VBO wrapper class holding indices data
 